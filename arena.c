@@ -0,0 +1,83 @@
+/* Implements a bump allocator: allocations are served from big blocks, and all released together. */
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "utils.h"
+
+/**
+ * Allocates a new block with room for at least the requested size
+ * @param mem The arena of the block
+ * @param size The requested size in bytes
+ * @return The new block
+ */
+static arena_block *new_block(arena *mem, long size) {
+	arena_block *block;
+	if (size < ARENA_BLOCK_SIZE) size = ARENA_BLOCK_SIZE;
+	if (mem->on_failure == NULL) {
+		block = calloc_with_check(sizeof(arena_block) + size);
+	} else if ((block = calloc(1, sizeof(arena_block) + size)) == NULL) {
+		longjmp(*mem->on_failure, 1);
+	}
+	block->size = size;
+	return block;
+}
+
+void arena_init(arena *mem) {
+	mem->blocks = mem->current = NULL;
+	mem->used = mem->allocations = 0;
+	mem->on_failure = NULL;
+}
+
+void *arena_alloc(arena *mem, long size) {
+	void *ptr;
+	arena_block *block = mem->current;
+	/* Round up, so the next allocation is aligned as well */
+	size = (size + sizeof(arena_align) - 1) / sizeof(arena_align) * sizeof(arena_align);
+	/* Move on to the next kept block (or a new one) if the current one is full */
+	if (block == NULL || block->used + size > block->size) {
+		if (block != NULL && block->next != NULL && block->next->size >= size) {
+			block = block->next;
+		} else {
+			arena_block *next = new_block(mem, size);
+			if (block == NULL) {
+				next->next = mem->blocks;
+				mem->blocks = next;
+			} else {
+				next->next = block->next;
+				block->next = next;
+			}
+			block = next;
+		}
+		block->used = 0;
+		mem->current = block;
+	}
+	ptr = (char *) block->data + block->used;
+	block->used += size;
+	mem->used += size;
+	mem->allocations++;
+	memset(ptr, 0, size);
+	return ptr;
+}
+
+char *arena_strdup(arena *mem, char *str) {
+	char *copy = arena_alloc(mem, strlen(str) + 1);
+	strcpy(copy, str);
+	return copy;
+}
+
+void arena_reset(arena *mem) {
+	/* Just start serving from the first block again */
+	mem->current = mem->blocks;
+	if (mem->current != NULL) mem->current->used = 0;
+	mem->used = mem->allocations = 0;
+}
+
+void arena_free(arena *mem) {
+	arena_block *prev_block, *curr_block = mem->blocks;
+	while (curr_block != NULL) {
+		prev_block = curr_block;
+		curr_block = curr_block->next;
+		free(prev_block);
+	}
+	arena_init(mem);
+}
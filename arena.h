@@ -0,0 +1,76 @@
+/* Implements a bump ("arena") allocator, for allocations that live as long as a single file's processing */
+#ifndef _ARENA_H
+#define _ARENA_H
+#include <setjmp.h>
+
+/** Default size of a single arena block, in bytes */
+#define ARENA_BLOCK_SIZE 65536L
+
+/** Aligns every allocation as strictly as any of these types */
+typedef union arena_align {
+	long l;
+	double d;
+	void *p;
+} arena_align;
+
+/** A single block of memory, which allocations are served from */
+typedef struct arena_block {
+	/** Next block in the arena */
+	struct arena_block *next;
+	/** Size of the block's data, in bytes */
+	long size;
+	/** Bytes already served from the block */
+	long used;
+	/** The block's data (the rest of the block follows) */
+	arena_align data[1];
+} arena_block;
+
+/** The arena itself */
+typedef struct arena {
+	/** The blocks of the arena, and the one allocations are currently served from */
+	arena_block *blocks;
+	arena_block *current;
+	/** Bytes served since the last reset */
+	long used;
+	/** Count of allocations since the last reset */
+	long allocations;
+	/** Where to jump if a block can't be allocated, or NULL to exit the program - for the library, which fails
+	 * instead. Cleared by arena_init */
+	jmp_buf *on_failure;
+} arena;
+
+/**
+ * Initializes an empty arena
+ * @param mem The arena to initialize
+ */
+void arena_init(arena *mem);
+
+/**
+ * Allocates zeroed memory from the arena. Jumps to the arena's on_failure if failed, or exits the program if not set.
+ * @param mem The arena
+ * @param size The size to allocate in bytes
+ * @return A generic pointer to the allocated memory
+ */
+void *arena_alloc(arena *mem, long size);
+
+/**
+ * Copies a string into memory allocated from the arena
+ * @param mem The arena
+ * @param str The string to copy
+ * @return A pointer to the copy
+ */
+char *arena_strdup(arena *mem, char *str);
+
+/**
+ * Releases everything allocated from the arena at once. The blocks are kept for the next allocations.
+ * @param mem The arena
+ */
+void arena_reset(arena *mem);
+
+/**
+ * Deallocates all the blocks of the arena
+ * @param mem The arena
+ */
+void arena_free(arena *mem);
+
+#endif
@@ -0,0 +1,192 @@
+/* The client of the assembler daemon - a drop-in replacement for the assembler's command line: the daemon assembles
+ * each file, and the client writes it's output files and prints it's messages, just like the assembler */
+/* Sockets & realpath, for connecting and sending paths */
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "globals.h"
+#include "assemble.h"
+#include "protocol.h"
+#include "source.h"
+#include "writefiles.h"
+#include "utils.h"
+
+/** The options that apply to every file */
+typedef struct client_options {
+	/** Whether to write the binary object (.obj) of each file as well (-b) */
+	bool binary;
+	/** Whether to send the paths of the sources, for the daemon to read (--paths), rather than the sources */
+	bool paths;
+	assemble_options assembling;
+} client_options;
+
+/**
+ * Connects to the daemon
+ * @param socket_path The daemon's socket
+ * @return The connected socket, or -1 if failed
+ */
+static int connect_daemon(char *socket_path) {
+	int fd;
+	struct sockaddr_un address;
+	if (strlen(socket_path) >= sizeof(address.sun_path) || (fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) return -1;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, socket_path);
+	if (connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/**
+ * Builds the request of a file
+ * @param input_filename The source file
+ * @param options The options
+ * @param size Where to return the size of the request
+ * @return The request's frame, or NULL if the source couldn't be read
+ */
+static unsigned char *file_request(char *input_filename, client_options *options, long *size) {
+	char *data = NULL, full_path[PATH_MAX];
+	long data_size;
+	unsigned char *request = NULL;
+	FILE *file_desc;
+	if (options->paths) {
+		/* The daemon might be in any directory */
+		if (realpath(input_filename, full_path) == NULL) return NULL;
+		return put_request(PATH_JOB, &options->assembling, full_path, strlen(full_path), size);
+	}
+	if ((file_desc = fopen(input_filename, "rb")) == NULL) return NULL;
+	if (read_whole_file(file_desc, &data, &data_size)) {
+		request = put_request(SOURCE_JOB, &options->assembling, data, data_size, size);
+	}
+	fclose(file_desc);
+	free(data);
+	return request;
+}
+
+/**
+ * Assembles a single file by the daemon, and writes it's outputs
+ * @param argument The filename, as given in the arguments. It's extension is ignored
+ * @param fd The daemon's socket
+ * @param options The options
+ * @param result The result to receive into
+ * @return Whether succeeded. Exits if the daemon can't be reached anymore
+ */
+static bool process_file(char *argument, int fd, client_options *options, assemble_result *result) {
+	long i, size;
+	bool is_success;
+	char *filename, *input_filename;
+	unsigned char *request, *response;
+	job_status status = JOB_UNREADABLE;
+
+	/* Drop the extension, like the assembler */
+	filename = strip_extension(argument);
+	input_filename = strallocat(filename, ".as");
+
+	if ((request = file_request(input_filename, options, &size)) != NULL) {
+		if (!send_frame(fd, request, size) || !receive_frame(fd, &response, &size)) {
+			printf("Error: The assembler daemon closed the connection.\n");
+			exit(1);
+		}
+		if (!get_response(response, size, &status, result)) {
+			printf("Error: The assembler daemon sent a broken response.\n");
+			exit(1);
+		}
+		free(response);
+		free(request);
+	}
+	if (status == JOB_UNREADABLE || status == JOB_INVALID) {
+		printf("Error: file \"%s\" is inaccessible for reading. skipping it.\n", filename);
+		free(input_filename);
+		free(filename);
+		return FALSE;
+	}
+
+	is_success = status == JOB_SUCCEEDED && write_text_object(&result->module, filename, stdout) &&
+	             (!options->binary || write_binary_object(&result->module, filename, stdout));
+	/* The errors of the lines go to stderr, and the errors of the whole file to stdout - like the assembler */
+	for (i = 0; i < result->diagnostic_count; i++) {
+		if (result->diagnostics[i].line_number > 0) {
+			fprintf(stderr, "Error In %s:%ld: %s\n", input_filename, result->diagnostics[i].line_number,
+			        result->diagnostics[i].message);
+		} else {
+			printf("Error: file \"%s\": %s\n", filename, result->diagnostics[i].message);
+		}
+	}
+	if (result->reached_max_errors) {
+		printf("Error: file \"%s\" reached the maximum of %ld errors. skipping the rest of it.\n", filename,
+		       options->assembling.max_errors);
+	}
+	free(input_filename);
+	free(filename);
+	return is_success;
+}
+
+/**
+ * Entry point - assembles the files of the arguments by the daemon
+ */
+int main(int argc, char *argv[]) {
+	int i, fd;
+	long file_count = 0;
+	char *socket_path = DEFAULT_SOCKET_PATH, *end, **filenames = calloc_with_check(argc * sizeof(char *));
+	client_options options;
+	assemble_result result;
+	options.binary = options.paths = FALSE;
+	options.assembling.max_errors = 0;
+
+	/* Collect the file names, and the options - the assembler's, and where the daemon is (--socket PATH) */
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-b") == 0) {
+			options.binary = TRUE;
+		} else if (strcmp(argv[i], "--paths") == 0) {
+			options.paths = TRUE;
+		} else if (strcmp(argv[i], "--socket") == 0) {
+			socket_path = argv[++i];
+			if (socket_path == NULL) {
+				printf("Error: --socket expects the path of the daemon's socket.\n");
+				free(filenames);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--max-errors") == 0) {
+			options.assembling.max_errors = i + 1 < argc ? strtol(argv[++i], &end, 10) : 0;
+			if (options.assembling.max_errors < 1 || *end != '\0') {
+				printf("Error: --max-errors expects a positive count of errors.\n");
+				free(filenames);
+				return 1;
+			}
+		} else if (argv[i][0] == '-') {
+			/* Not a file - an option of the assembler that the client doesn't have (-j, --cache, --stats, stdin) */
+			printf("Error: asmc doesn't support the option %s.\n", argv[i]);
+			free(filenames);
+			return 1;
+		} else {
+			filenames[file_count++] = argv[i];
+		}
+	}
+	if ((fd = connect_daemon(socket_path)) < 0) {
+		printf("Error: Can't connect to the assembler daemon at %s.\n", socket_path);
+		free(filenames);
+		return 1;
+	}
+
+	init_assemble_result(&result);
+	printf("argc: %ld\n", file_count);
+	for (i = 0; i < file_count; i++) {
+		printf("\nfile[%d] is: %s\n", i + 1, filenames[i]);
+		fputs(process_file(filenames[i], fd, &options, &result) ? "File - Succeeded\n\n" : "File - Failed\n\n",
+		      stdout);
+		fflush(stdout);
+	}
+
+	free_assemble_result(&result);
+	close(fd);
+	free(filenames);
+	return 0;
+}
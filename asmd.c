@@ -0,0 +1,184 @@
+/* The assembler daemon - stays resident, and assembles the jobs it receives over a Unix domain socket.
+ * Each worker of the pool accepts connections by itself, and keeps it's result (and it's arena) for all of it's jobs */
+/* Sockets, for listening */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "globals.h"
+#include "assemble.h"
+#include "protocol.h"
+#include "pool.h"
+#include "source.h"
+#include "utils.h"
+
+/** Maximum count of connections waiting to be accepted */
+#define LISTEN_BACKLOG 64
+
+/** Seconds a connection may stay silent (or not read it's response) before it's closed, so it won't hold a worker */
+#define IDLE_TIMEOUT_SECONDS 30
+
+/**
+ * Runs a single job of a connection
+ * @param content The request's frame content
+ * @param size The size of the content
+ * @param result The worker's result, to assemble into
+ * @param response_size Where to return the size of the response
+ * @return The response's frame, or NULL if out of memory
+ */
+static unsigned char *run_job(unsigned char *content, long size, assemble_result *result, long *response_size) {
+	job_request request;
+	job_status status;
+	char *source = NULL;
+	long source_size;
+	FILE *file_desc;
+	if (!get_request(content, size, &request)) return put_response(JOB_INVALID, result, response_size);
+	if (request.kind == PATH_JOB) {
+		/* The path is relative to the daemon's directory - clients send absolute paths */
+		file_desc = fopen(request.payload, "rb");
+		if (file_desc == NULL || !read_whole_file(file_desc, &source, &source_size)) {
+			if (file_desc != NULL) fclose(file_desc);
+			free(source);
+			return put_response(JOB_UNREADABLE, result, response_size);
+		}
+		fclose(file_desc);
+		status = assemble(source, source_size, &request.options, result) ? JOB_SUCCEEDED : JOB_FAILED;
+		free(source);
+	} else {
+		status = assemble(request.payload, request.length, &request.options, result) ? JOB_SUCCEEDED : JOB_FAILED;
+	}
+	return put_response(status, result, response_size);
+}
+
+/**
+ * Serves connections until the daemon stops - a job of the worker pool, for each worker
+ * @param job Unused
+ * @param worker Unused
+ * @param context The listening socket
+ */
+static void serve(long job, int worker, void *context) {
+	int listen_fd = *(int *) context, fd;
+	long size, response_size;
+	unsigned char *content, *response;
+	bool is_connected;
+	struct timeval timeout;
+	assemble_result result;
+	init_assemble_result(&result);
+	timeout.tv_sec = IDLE_TIMEOUT_SECONDS;
+	timeout.tv_usec = 0;
+	while (TRUE) {
+		if ((fd = accept(listen_fd, NULL, NULL)) < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) continue;
+			perror("Error: accept");
+			break;
+		}
+		/* A timed out read or write fails, which ends the connection */
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+		/* Any count of jobs over a connection, one after the other */
+		for (is_connected = TRUE; is_connected && receive_frame(fd, &content, &size);) {
+			/* Without memory for the response, the client sees the connection closed */
+			response = run_job(content, size, &result, &response_size);
+			is_connected = response != NULL && send_frame(fd, response, response_size);
+			free(response);
+			free(content);
+		}
+		close(fd);
+	}
+	free_assemble_result(&result);
+}
+
+/**
+ * Removes the socket of a previous daemon that is gone. Anything else at the path is kept
+ * @param address The socket's address
+ * @return Whether the path is free to listen on. Prints why, if it isn't
+ */
+static bool remove_stale_socket(struct sockaddr_un *address) {
+	int fd;
+	bool is_alive;
+	struct stat info;
+	if (lstat(address->sun_path, &info) != 0) {
+		if (errno == ENOENT) return TRUE;
+		printf("Error: Can't replace the socket %s.\n", address->sun_path);
+		return FALSE;
+	}
+	if (!S_ISSOCK(info.st_mode)) {
+		printf("Error: %s exists, and isn't a socket.\n", address->sun_path);
+		return FALSE;
+	}
+	/* A daemon that still listens accepts the connection */
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0) {
+		is_alive = connect(fd, (struct sockaddr *) address, sizeof(struct sockaddr_un)) == 0;
+		close(fd);
+		if (is_alive) {
+			printf("Error: Another assembler daemon is listening on %s.\n", address->sun_path);
+			return FALSE;
+		}
+	}
+	if (fd < 0 || unlink(address->sun_path) != 0) {
+		printf("Error: Can't replace the socket %s.\n", address->sun_path);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Does nothing - the workers serve until the daemon stops
+ */
+static void report_nothing(long job, int worker, void *context) {
+}
+
+/**
+ * Entry point - the assembler daemon
+ */
+int main(int argc, char *argv[]) {
+	int i, listen_fd, worker_count = 1;
+	char *socket_path = DEFAULT_SOCKET_PATH, *end;
+	struct sockaddr_un address;
+
+	/* Collect the count of workers (-j N), and where to listen (--socket PATH) */
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			worker_count = (int) strtol(argv[++i], &end, 10);
+			if (worker_count < 1 || *end != '\0') {
+				printf("Error: -j expects a positive count of workers.\n");
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+			socket_path = argv[++i];
+		} else {
+			printf("Usage: %s [-j workers] [--socket path]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (strlen(socket_path) >= sizeof(address.sun_path)) {
+		printf("Error: The socket's path %s is too long.\n", socket_path);
+		return 1;
+	}
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, socket_path);
+	/* A socket left by a previous daemon is replaced */
+	if (!remove_stale_socket(&address)) return 1;
+	if ((listen_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+	    bind(listen_fd, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(listen_fd, LISTEN_BACKLOG) != 0) {
+		printf("Error: Can't listen on %s.\n", socket_path);
+		return 1;
+	}
+	printf("Listening on %s, with %d workers.\n", socket_path, worker_count);
+	fflush(stdout);
+
+	run_jobs(worker_count, worker_count, serve, report_nothing, &listen_fd);
+
+	close(listen_fd);
+	unlink(socket_path);
+	return 1;
+}
@@ -0,0 +1,150 @@
+/* Implements the assembler library. The passes collect their errors as records in the result's arena, rather than
+ * printing them - they're the result's diagnostics at the end. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "assemble.h"
+#include "first_pass.h"
+#include "second_pass.h"
+#include "code.h"
+#include "writefiles.h"
+#include "source.h"
+#include "utils.h"
+
+/** The file name of the source */
+#define SOURCE_NAME "source"
+
+/** The memory of assembling a source, besides the result's arena. It's on the heap, so it's still as it was when an
+ * allocation from the arena fails and jumps back to assemble */
+typedef struct assembling {
+	source_file source;
+	fpass_state state;
+	diagnostic_sink sink;
+	error_budget errors;
+} assembling;
+
+/** The only diagnostic of a source that ran out of memory - it isn't allocated, as there's no memory for it */
+static assemble_diagnostic out_of_memory = {0, "Out of memory - the source is too large to process."};
+
+void init_assemble_result(assemble_result *result) {
+	memset(result, 0, sizeof(assemble_result));
+	arena_init(&result->mem);
+}
+
+void free_assemble_result(assemble_result *result) {
+	arena_free(&result->mem);
+	init_assemble_result(result);
+}
+
+/**
+ * Copies the collected errors into the result's diagnostics
+ * @param result The result
+ * @param sink The errors
+ */
+static void collect_diagnostics(assemble_result *result, diagnostic_sink *sink) {
+	diagnostic_record *curr;
+	assemble_diagnostic *curr_diagnostic;
+	result->diagnostics = arena_alloc(&result->mem, (sink->count + 1) * sizeof(assemble_diagnostic));
+	result->diagnostic_count = sink->count;
+	for (curr = sink->first, curr_diagnostic = result->diagnostics; curr != NULL; curr = curr->next, curr_diagnostic++) {
+		curr_diagnostic->line_number = curr->line_number;
+		curr_diagnostic->message = curr->message;
+	}
+}
+
+/**
+ * Assembles a source into the result, collecting it's errors
+ * @param text The text of the source
+ * @param length The length of the text, in bytes
+ * @param options The options, or NULL for the defaults
+ * @param work The memory of assembling, zeroed - deallocated by the caller
+ * @param result The result, which was reset
+ * @return Whether succeeded
+ */
+static bool assemble_source(const char *text, size_t length, assemble_options *options, assembling *work,
+                            assemble_result *result) {
+	long icf, dcf;
+	bool is_success;
+	line_info line;
+	arena *mem = &result->mem;
+	fpass_state *state = &work->state;
+
+	work->sink.mem = mem;
+	line.diagnostics = &work->sink;
+	line.error_output = NULL;
+	line.file_name = SOURCE_NAME;
+	line.errors = &work->errors;
+	work->errors.max = options != NULL ? options->max_errors : 0;
+
+	if (!copy_source(&work->source, text, (long) length) ||
+	    !init_fpass_state(state, work->source.line_count, mem)) {
+		add_diagnostic(&work->sink, 0, "The source is too large to process.");
+		return FALSE;
+	}
+	/* A single chunk - the caller assembles sources in parallel, if it wants to. It also keeps the library off the
+	 * chunks' allocations, which exit the program if they fail */
+	is_success = first_pass(&work->source, line, 1, state);
+	icf = state->ic;
+	dcf = state->dc;
+	if (is_success && !reserve_code_image(&state->code, icf - IC_INIT_VALUE + dcf)) {
+		add_diagnostic(&work->sink, 0, "The source is too large to process.");
+		is_success = FALSE;
+	}
+	if (is_success) {
+		merge_data_and_code_img(state->code.words, state->data.words, icf, dcf, mem);
+		add_value_to_type(state->symbol_table, icf, DATA_SYMBOL);
+		is_success = resolve_symbols(&state->ir, &state->names, line, state->code.words, &state->symbol_table, mem);
+	}
+	/* The module lives in the result's arena, with the table */
+	if (is_success) get_object_module(state->code.words, icf, dcf, state->symbol_table, &result->module);
+	result->reached_max_errors = OUT_OF_ERRORS(&work->errors);
+	return is_success;
+}
+
+/**
+ * Resets a result to the only diagnostic of running out of memory - whatever it held may be half built
+ * @param result The result
+ */
+static void fail_out_of_memory(assemble_result *result) {
+	arena_reset(&result->mem);
+	memset(&result->module, 0, sizeof(object_module));
+	result->succeeded = FALSE;
+	result->reached_max_errors = FALSE;
+	result->diagnostics = &out_of_memory;
+	result->diagnostic_count = 1;
+}
+
+bool assemble(const char *source, size_t length, assemble_options *options, assemble_result *result) {
+	jmp_buf on_failure;
+	assembling *work;
+	arena *mem = &result->mem;
+
+	/* Start over, reusing the result's memory */
+	arena_reset(mem);
+	memset(&result->module, 0, sizeof(object_module));
+	result->succeeded = FALSE;
+	result->diagnostics = NULL;
+	result->diagnostic_count = 0;
+	result->reached_max_errors = FALSE;
+	if ((work = calloc(1, sizeof(assembling))) == NULL) {
+		fail_out_of_memory(result);
+		return FALSE;
+	}
+
+	/* Running out of memory in the arena or the line IR jumps back here, instead of exiting. The other allocations of
+	 * the library return their failure */
+	mem->on_failure = &on_failure;
+	if (setjmp(on_failure) == 0) {
+		result->succeeded = assemble_source(source, length, options, work, result);
+		collect_diagnostics(result, &work->sink);
+	} else {
+		fail_out_of_memory(result);
+	}
+	mem->on_failure = NULL;
+
+	free_fpass_state(&work->state);
+	free_source(&work->source);
+	free(work);
+	return result->succeeded;
+}
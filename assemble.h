@@ -0,0 +1,62 @@
+/* Implements the assembler as a library (libassembler.a): a source in memory is assembled into it's words, symbols
+ * and errors - without touching any file, printing anything or keeping any state between calls.
+ * It uses the worker pool, so programs that use it are linked with -pthread. */
+#ifndef _ASSEMBLE_H
+#define _ASSEMBLE_H
+#include <stddef.h>
+#include "globals.h"
+#include "arena.h"
+#include "object.h"
+
+/** The options of assembling a source */
+typedef struct assemble_options {
+	/** The count of errors after which the source stops being analyzed, 0 for unlimited */
+	long max_errors;
+} assemble_options;
+
+/** A single error of a source */
+typedef struct assemble_diagnostic {
+	/** The line of the error, or 0 if it's about the whole source */
+	long line_number;
+	/** The message, as the assembler prints it after the line */
+	char *message;
+} assemble_diagnostic;
+
+/** The result of assembling a source. Everything in it is allocated from it's own arena */
+typedef struct assemble_result {
+	bool succeeded;
+	/** The words (the code, then the data) with their ARE, the entries and the externals (only if succeeded) */
+	object_module module;
+	/** The errors, by the order they were found */
+	assemble_diagnostic *diagnostics;
+	long diagnostic_count;
+	/** Whether the maximum count of errors was reached, so the rest of the source wasn't analyzed */
+	bool reached_max_errors;
+	/** The memory of the result - reused by each assembling into it */
+	arena mem;
+} assemble_result;
+
+/**
+ * Initializes a result, before assembling into it for the first time
+ * @param result The result
+ */
+void init_assemble_result(assemble_result *result);
+
+/**
+ * Deallocates everything of a result
+ * @param result The result
+ */
+void free_assemble_result(assemble_result *result);
+
+/**
+ * Assembles a source. Reentrant - different results can be assembled into at the same time.
+ * Running out of memory fails the source (with a diagnostic), rather than the program.
+ * @param source The text of the source
+ * @param length The length of the text, in bytes
+ * @param options The options, or NULL for the defaults
+ * @param result The result to assemble into. Whatever it held before is released
+ * @return Whether succeeded
+ */
+bool assemble(const char *source, size_t length, assemble_options *options, assemble_result *result);
+
+#endif
@@ -1,3 +1,5 @@
+/* open_memstream, for buffering the output of each file */
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -6,149 +8,403 @@
 #include "first_pass.h"
 #include "second_pass.h"
 #include "code.h"
+#include "arena.h"
+#include "image.h"
+#include "pool.h"
+#include "source.h"
+#include "cache.h"
+#include "stats.h"
+
+/** The argument of reading the source from stdin, and streaming the outputs */
+#define STDIN_ARGUMENT "-"
+
+/** The name of the source read from stdin, for the messages */
+#define STDIN_FILENAME "stdin"
+
+/** A single file to assemble, and it's buffered output */
+typedef struct file_job {
+	/** The file name, as given in the arguments */
+	char *filename;
+	/** The text the file printed to stdout, when buffered */
+	char *output_text;
+	size_t output_size;
+	/** The text the file printed to stderr - always buffered, so it's written at once */
+	char *error_text;
+	size_t error_size;
+	/** The file's status, and whether it stopped at the maximum count of errors - printed after it's line errors */
+	char *status_text;
+	size_t status_size;
+} file_job;
+
+/** The options that apply to every file */
+typedef struct file_options {
+	/** The count of threads for the first pass of each file - the workers left over by the files */
+	int chunk_workers;
+	/** Whether to write the binary object (.obj) of each file as well (-b) */
+	bool binary;
+	/** The directory to cache the outputs in (--cache DIR), or NULL if not cached */
+	char *cache_dir;
+	/** The count of errors after which a file stops being analyzed (--max-errors N), 0 for unlimited */
+	long max_errors;
+	/** Where the outputs of the source from stdin are streamed to: the object to stdout, and the externals
+	 * and the entries to the descriptors of --ext-fd N and --ent-fd N (dropped if not given) */
+	output_streams streams;
+} file_options;
+
+/** The files to assemble, and the resources of the workers */
+typedef struct assembly {
+	file_job *jobs;
+	/** An arena for each worker, so it's blocks are reused by all the files of the worker */
+	arena *arenas;
+	/** Whether the messages of each file are buffered until it's reported (when running in parallel) */
+	bool buffered;
+	/** The stream to print the messages to - stderr when stdout is the output of stdin's source */
+	FILE *messages;
+	file_options options;
+	/** The statistics of each file (--stats FILE), or NULL if not measured */
+	file_stats *stats;
+} assembly;
 
 /**
  * Processes a single assembly source file, and returns the result status.
- * @param filename The filename, without it's extension
+ * @param argument The filename, as given in the arguments. It's extension is ignored
+ * @param mem The arena to allocate the file's structures from. Everything allocated from it is released at the end.
+ * @param options The options of the files
+ * @param output The stream to print the messages to
+ * @param error_output The stream to print the line errors to
+ * @param status_output The stream to print the messages that follow the line errors to
+ * @param stats The statistics of the file, or NULL if not measured
  * @return Whether succeeded
  */
-static bool process_file(char *filename);
+static bool process_file(char *argument, arena *mem, file_options *options, FILE *output, FILE *error_output,
+                         FILE *status_output, file_stats *stats);
+
+/**
+ * Assembles a single file of the arguments - a job of the worker pool
+ * @param job The index of the file
+ * @param worker The index of the worker, which owns the arena to use
+ * @param context The assembly
+ */
+static void assemble_job(long job, int worker, void *context);
+
+/**
+ * Prints the buffered output of an assembled file - called in the arguments order
+ * @param job The index of the file
+ * @param worker Unused
+ * @param context The assembly
+ */
+static void report_job(long job, int worker, void *context);
 
-void merge_data_and_code_img(machine_word** memory_img, long* data_img, long icf, long dcf);
+/**
+ * Opens a descriptor of the arguments as an output stream
+ * @param argument The descriptor's number, or NULL if missing
+ * @param option The option, for the error message
+ * @return The stream, or NULL if the argument isn't an open descriptor
+ */
+static FILE *open_descriptor(char *argument, char *option) {
+	char *end;
+	long fd = argument == NULL ? -1 : strtol(argument, &end, 10);
+	FILE *stream = fd >= 0 && *end == '\0' ? fdopen((int) fd, "w") : NULL;
+	if (stream == NULL) printf("Error: %s expects a file descriptor, that is open for writing.\n", option);
+	return stream;
+}
 
 /**
  * Entry point - 24bit assembler. Assembly language specified in booklet.
  */
 int main(int argc, char *argv[]) {
-	int i;
+	int i, worker_count = 1;
+	long file_count = 0;
+	char *count_text, *end, *stats_filename = NULL;
+	FILE *stream;
+	double start_time = 0;
+	assembly all;
 
-	/* To break line if needed */
-	bool succeeded = TRUE;
-	printf("argc: %d\n", argc-1);
+	all.jobs = calloc_with_check(argc * sizeof(file_job));
+	all.options.binary = FALSE;
+	all.options.cache_dir = NULL;
+	all.options.max_errors = 0;
+	all.options.streams.object = stdout;
+	all.options.streams.externals = all.options.streams.entries = NULL;
+	all.messages = stdout;
+	all.stats = NULL;
+	/* Collect the file names, the count of workers (-j N), whether to write binary objects (-b), the cache,
+	 * where to write the statistics, the maximum count of errors of a file, and where to stream stdin's outputs */
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-b") == 0) {
+			all.options.binary = TRUE;
+		} else if (strcmp(argv[i], "--stats") == 0) {
+			stats_filename = argv[++i];
+			if (stats_filename == NULL) {
+				printf("Error: --stats expects a file to write the statistics to.\n");
+				free(all.jobs);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--cache") == 0) {
+			all.options.cache_dir = argv[++i];
+			if (all.options.cache_dir == NULL || !prepare_cache(all.options.cache_dir)) {
+				printf("Error: --cache expects a directory, that exists or can be created.\n");
+				free(all.jobs);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--max-errors") == 0) {
+			count_text = argv[++i];
+			all.options.max_errors = count_text == NULL ? 0 : strtol(count_text, &end, 10);
+			if (all.options.max_errors < 1 || *end != '\0') {
+				printf("Error: --max-errors expects a positive count of errors.\n");
+				free(all.jobs);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--ext-fd") == 0 || strcmp(argv[i], "--ent-fd") == 0) {
+			stream = open_descriptor(argv[i + 1], argv[i]);
+			if (stream == NULL) {
+				free(all.jobs);
+				return 1;
+			}
+			if (strcmp(argv[i++], "--ext-fd") == 0) all.options.streams.externals = stream;
+			else all.options.streams.entries = stream;
+		} else if (strncmp(argv[i], "-j", 2) == 0) {
+			count_text = argv[i][2] != '\0' ? argv[i] + 2 : argv[++i];
+			worker_count = count_text == NULL ? 0 : (int) strtol(count_text, &end, 10);
+			if (worker_count < 1 || *end != '\0') {
+				printf("Error: -j expects a positive count of workers.\n");
+				free(all.jobs);
+				return 1;
+			}
+		} else {
+			if (strcmp(argv[i], STDIN_ARGUMENT) == 0) {
+				if (all.messages == stderr) {
+					printf("Error: stdin (%s) can only be assembled once.\n", STDIN_ARGUMENT);
+					free(all.jobs);
+					return 1;
+				}
+				/* stdout is the object's stream now */
+				all.messages = stderr;
+			}
+			all.jobs[file_count++].filename = argv[i];
+		}
+	}
+	fprintf(all.messages, "argc: %ld\n", file_count);
 
-	/* Process each file by arguments */
-	for (i = 1; argv[i] != NULL; ++i) {
-		printf("\nfile[%d] is: %s\n", i,argv[i]);
+	all.buffered = worker_count > 1;
+	all.options.chunk_workers = file_count > 0 && file_count < worker_count ? (int) (worker_count / file_count) : 1;
+	all.arenas = calloc_with_check(worker_count * sizeof(arena));
+	for (i = 0; i < worker_count; i++) arena_init(&all.arenas[i]);
+	if (stats_filename != NULL) {
+		all.stats = calloc_with_check((file_count + 1) * sizeof(file_stats));
+		start_time = stats_wall_clock();
+	}
 
-		/* foreach argument (file name), send it for full processing. */
-		succeeded = process_file(argv[i]);
-		/* if last process failed and there's another file, break line: */
-		if (!succeeded) puts("File - Failed\n");
-		if (succeeded) puts("File - Succeeded\n");
+	/* Process each file by arguments, the output is printed by the arguments order */
+	run_jobs(file_count, worker_count, assemble_job, report_job, &all);
+
+	if (all.stats != NULL && !write_stats(stats_filename, all.stats, file_count, worker_count,
+	                                      stats_wall_clock() - start_time)) {
+		fprintf(all.messages, "Error: Can't write the statistics to file %s.\n", stats_filename);
 	}
+	free(all.stats);
+
+	for (i = 0; i < worker_count; i++) arena_free(&all.arenas[i]);
+	free(all.arenas);
+	free(all.jobs);
 	return 0;
 }
 
-void merge_data_and_code_img(machine_word** memory_img, long* data_img, long icf, long dcf) {
-	int i;
-	machine_word* word_to_write;
-	data_word* dataword;
-
-	for (i = 0; i < dcf; i++) {
-		word_to_write = (machine_word*)calloc_with_check(sizeof(machine_word));
-		word_to_write->length = 0; /* Not Code word! */
-		dataword = (data_word*)calloc_with_check(sizeof(data_word));
-		dataword->ARE = A_MEM;	/* data word is always "A" */
-		dataword->data = data_img[i]; /* insert the data into "dataword" */
-		word_to_write->word.data = dataword;
-		memory_img[icf - IC_INIT_VALUE + i] = word_to_write;
+static void assemble_job(long job, int worker, void *context) {
+	assembly *all = context;
+	file_job *curr_job = &all->jobs[job];
+	FILE *output = all->messages, *error_output, *status_output;
+	file_stats *stats = all->stats != NULL ? &all->stats[job] : NULL;
+	bool succeeded;
+	/* The errors are always collected, and written at once when the file is reported */
+	error_output = open_memstream(&curr_job->error_text, &curr_job->error_size);
+	status_output = open_memstream(&curr_job->status_text, &curr_job->status_size);
+	if (all->buffered) output = open_memstream(&curr_job->output_text, &curr_job->output_size);
+	if (output == NULL || error_output == NULL || status_output == NULL) {
+		printf("Error: Fatal: Memory allocation failed.");
+		exit(1);
+	}
+	fprintf(output, "\nfile[%ld] is: %s\n", job + 1, curr_job->filename);
+
+	/* foreach argument (file name), send it for full processing. */
+	start_file_stats(stats, curr_job->filename);
+	succeeded = process_file(curr_job->filename, &all->arenas[worker], &all->options, output, error_output,
+	                         status_output, stats);
+	stop_file_stats(stats, succeeded);
+	fputs(succeeded ? "File - Succeeded\n\n" : "File - Failed\n\n", status_output);
+
+	if (all->buffered) fclose(output);
+	fclose(error_output);
+	fclose(status_output);
+}
+
+static void report_job(long job, int worker, void *context) {
+	assembly *all = context;
+	file_job *curr_job = &all->jobs[job];
+	/* Unless buffered, the output was already printed */
+	if (all->buffered) {
+		fwrite(curr_job->output_text, 1, curr_job->output_size, all->messages);
+		free(curr_job->output_text);
 	}
+	fflush(all->messages);
+	fwrite(curr_job->error_text, 1, curr_job->error_size, stderr);
+	free(curr_job->error_text);
+	/* The status comes after the line errors, as when they were printed while assembling */
+	fflush(stderr);
+	fwrite(curr_job->status_text, 1, curr_job->status_size, all->messages);
+	free(curr_job->status_text);
+}
+
+/**
+ * Records the counters of a processed file in it's statistics, before it's arena is reset
+ * @param stats The statistics of the file, or NULL if not measured
+ * @param state The state of the file's passes
+ * @param mem The file's arena
+ */
+static void record_counters(file_stats *stats, fpass_state *state, arena *mem) {
+	if (stats == NULL) return;
+	stats->words = state->ic - IC_INIT_VALUE + state->dc;
+	stats->symbol_lookups = state->symbol_table->lookups;
+	stats->symbol_probes = state->symbol_table->probes;
+	stats->allocations = mem->allocations;
+	stats->allocated_bytes = mem->used;
 }
 
-static bool process_file(char *filename) {
+static bool process_file(char *argument, arena *mem, file_options *options, FILE *output, FILE *error_output,
+                         FILE *status_output, file_stats *stats) {
 	/* Memory address counters */
-	int temp_c;
-	long ic = IC_INIT_VALUE, dc = 0, icf, dcf;
+	long icf, dcf;
 	bool is_success = TRUE; /* is succeeded so far */
+	char *filename; /* The argument, without it's extension */
 	char *input_filename = NULL;
-	char temp_line[MAX_LINE_LENGTH + 2]; /* temporary string for storing line, read from file */
+	char *key = NULL; /* The cache key of the source */
+	bool streamed = strcmp(argument, STDIN_ARGUMENT) == 0; /* Read from stdin, and the outputs are streamed */
 	FILE *file_des; /* Current assembly file descriptor to process */
-	long data_img[CODE_ARR_IMG_LENGTH]; /* Contains an image of the machine code */
-	machine_word *memory_img[CODE_ARR_IMG_LENGTH];
-	/* Our symbol table */
-	table symbol_table = NULL;
-	line_info curr_line_info;
+	source_file source; /* The whole source, read at once */
+	/* The images, the symbol table and the parsed lines */
+	fpass_state state;
+	line_info file_line_info;
+	error_budget errors; /* The errors of the file, so far */
 
-	input_filename = strtok(filename, ".");
+	if (streamed) {
+		/* Just a name for the messages - nothing is written next to it */
+		filename = strallocat(STDIN_FILENAME, "");
+	} else {
+		/* Drop the extension, without changing the argument itself */
+		filename = strip_extension(argument);
+	}
 
 	/* Concat extensionless filename with .as extension */
 	input_filename = strallocat(filename, ".as");
-	//input_filename = "fpass_errors.as"; //debug
-	/* Open file, skip on failure */
-	file_des = fopen(input_filename, "r");
-	if (file_des == NULL) {
-		/* if file couldn't be opened, write to stderr. */
-		printf("Error: file \"%s\" is inaccessible for reading. skipping it.\n", filename);
-		free(input_filename); /* The only allocated space is for the full file name */
+	/* Open file and read it all at once, skip on failure. stdin may be a pipe - it's read the same */
+	file_des = streamed ? stdin : fopen(input_filename, "r");
+	if (file_des == NULL || !read_source(&source, file_des)) {
+		/* if file couldn't be read, write to stderr. */
+		fprintf(output, "Error: file \"%s\" is inaccessible for reading. skipping it.\n", filename);
+		if (file_des != NULL) {
+			free_source(&source);
+			if (!streamed) fclose(file_des);
+		}
+		free(input_filename); /* The only allocated space is for the file names */
+		free(filename);
+		end_phase(stats, READ_PHASE);
 		return FALSE;
 	}
+	/* The passes only go over the source in memory */
+	if (!streamed) fclose(file_des);
+	if (stats != NULL) stats->lines = source.line_count;
 
-	/* start first pass: */
-	curr_line_info.file_name = input_filename;
-	curr_line_info.content = temp_line; /* We use temp_line to read from the file, but it stays at same location. */
-	/* Read line - stop if read failed (when NULL returned) - usually when EOF. increase line counter for error printing. */
-	for (curr_line_info.line_number = 1;
-	     fgets(temp_line, MAX_LINE_LENGTH + 2, file_des) != NULL; curr_line_info.line_number++) {
-		/* if line too long, the buffer doesn't include the '\n' char OR the file isn't on end. */
-		if (strchr(temp_line, '\n') == NULL && !feof(file_des)) {
-			/* Print message and prevent further line processing, as well as second pass.  */
-			printf_line_error(curr_line_info, "Line too long to process. Maximum line length should be %d.",
-			                  MAX_LINE_LENGTH);
-			is_success = FALSE;
-			/* skip leftovers */
-			do {
-				temp_c = fgetc(file_des);
-			} while (temp_c != '\n' && temp_c != EOF);
-		} else {
-			if (!process_line_fpass(curr_line_info, &ic, &dc, memory_img, data_img, &symbol_table)) {
-				if (is_success) {
-					/*free_code_image(memory_img, ic_before);*/
-					icf = -1;
-					is_success = FALSE;
-				}
-			}
+	/* Skip all the work if the outputs of the same source are cached (as files - streamed outputs aren't) */
+	if (options->cache_dir != NULL && !streamed) {
+		key = cache_key(&source, options->binary);
+		if (restore_from_cache(options->cache_dir, key, filename, output)) {
+			end_phase(stats, READ_PHASE);
+			count_output_bytes(stats, filename, options->binary);
+			free(key);
+			free_source(&source);
+			free(input_filename);
+			free(filename);
+			return TRUE;
 		}
 	}
+	end_phase(stats, READ_PHASE);
+
+	/* Allocate the images once, big enough for the file's code */
+	if (!init_fpass_state(&state, source.line_count, mem)) {
+		fprintf(output, "Error: file \"%s\" is too large to process. skipping it.\n", filename);
+		free_fpass_state(&state);
+		free_source(&source);
+		arena_reset(mem);
+		free(key);
+		free(input_filename);
+		free(filename);
+		return FALSE;
+	}
+
+	/* start first pass: */
+	file_line_info.file_name = input_filename;
+	file_line_info.error_output = error_output;
+	file_line_info.diagnostics = NULL;
+	file_line_info.errors = &errors;
+	errors.count = 0;
+	errors.max = options->max_errors;
+	is_success = first_pass(&source, file_line_info, options->chunk_workers, &state);
+
+	/* The source isn't needed anymore - the second pass only goes over the IR */
+	free_source(&source);
 
 	/* Save ICF & DCF */
-	icf = ic;
-	dcf = dc;
+	icf = state.ic;
+	dcf = state.dc;
 
 	/* Merge data image and code image at the end of the memory image */
-	merge_data_and_code_img(memory_img, data_img, icf, dcf);
+	if (is_success && !reserve_code_image(&state.code, icf - IC_INIT_VALUE + dcf)) {
+		fprintf(output, "Error: file \"%s\" is too large to process. skipping it.\n", filename);
+		is_success = FALSE;
+	}
+	if (is_success) merge_data_and_code_img(state.code.words, state.data.words, icf, dcf, mem);
+	end_phase(stats, FIRST_PASS_PHASE);
 
 
 	/* if first pass didn't fail, start the second pass */
 	if (is_success) {
 
-		ic = IC_INIT_VALUE;
-
 		/* Now let's add IC to each DC for each of the data symbols in table (step 1.19) */
-		add_value_to_type(symbol_table, icf, DATA_SYMBOL);
-
-		/* First pass done right. start second pass: */
-		rewind(file_des); /* Start from beginning of file again */
+		add_value_to_type(state.symbol_table, icf, DATA_SYMBOL);
 
-		for (curr_line_info.line_number = 1; !feof(file_des); curr_line_info.line_number++) {
-			int i = 0;
-			fgets(temp_line, MAX_LINE_LENGTH, file_des); /* Get line */
-			MOVE_TO_NOT_WHITE(temp_line, i)
-			if (memory_img[ic - IC_INIT_VALUE] != NULL || temp_line[i] == '.')
-				is_success &= process_line_spass(curr_line_info, &ic, memory_img, &symbol_table);
-		}
+		/* First pass done right. start second pass - resolve the symbol usages: */
+		is_success = resolve_symbols(&state.ir, &state.names, file_line_info, state.code.words, &state.symbol_table,
+		                             mem);
+		end_phase(stats, SECOND_PASS_PHASE);
 
 			/* Write files if second pass succeeded */
 			if (is_success) {
 				/* Everything was done. Write to *filename.ob/.ext/.ent */
-				is_success = write_output_files(memory_img, data_img, icf, dcf, filename, symbol_table);
+				is_success = write_output_files(state.code.words, state.data.words, icf, dcf, filename,
+				                                state.symbol_table, options->binary,
+				                                streamed ? &options->streams : NULL, output);
+			}
+			/* A failure to cache the outputs is reported, but they were written anyway */
+			if (is_success && key != NULL) {
+				store_in_cache(options->cache_dir, key, filename, options->binary, output);
 			}
+			if (is_success && !streamed) count_output_bytes(stats, filename, options->binary);
+			end_phase(stats, WRITE_PHASE);
 	}
 
-	/* Free symbol table */
-	free_table(symbol_table);
-	/* Free code & data buffer contents */
-	free_code_image(memory_img, icf);
+	if (OUT_OF_ERRORS(&errors)) {
+		fprintf(status_output, "Error: file \"%s\" reached the maximum of %ld errors. skipping the rest of it.\n", filename,
+		        errors.max);
+	}
+
+	/* Release the symbol table and the code & data words, all at once */
+	record_counters(stats, &state, mem);
+	arena_reset(mem);
+	free_fpass_state(&state);
+	free(key);
+	free(input_filename);
+	free(filename);
 
 	/* return whether every assembling succeeded */
 	return is_success;
-}
\ No newline at end of file
+}
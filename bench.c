@@ -0,0 +1,209 @@
+/* Benchmarks the assembler over a corpus: the throughput of assembling it all at once, and the latency of each file */
+/* fork, exec & clock_gettime, for running the assembler and timing it */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "globals.h"
+#include "source.h"
+#include "utils.h"
+
+/** A single source of the corpus */
+typedef struct bench_file {
+	/** The file name, without it's extension */
+	char *filename;
+	/** Count of lines of the source, and of words of it's output (if assembled) */
+	long lines;
+	long words;
+} bench_file;
+
+/**
+ * Returns the time of a monotonic clock
+ * @return The time, in seconds
+ */
+static double now(void) {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * Runs a program, with it's output discarded, and waits for it
+ * @param arguments The NULL-terminated arguments, starting with the program
+ * @return Whether it ran and exited with status 0
+ */
+static bool run_quietly(char **arguments) {
+	int status, null_fd;
+	pid_t child = fork();
+	if (child == 0) {
+		null_fd = open("/dev/null", O_WRONLY);
+		dup2(null_fd, STDOUT_FILENO);
+		dup2(null_fd, STDERR_FILENO);
+		execv(arguments[0], arguments);
+		_exit(127);
+	}
+	return child > 0 && waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/**
+ * Reads the count of lines of a source
+ * @param curr The file - it's count of lines is set
+ * @return Whether succeeded
+ */
+static bool count_lines(bench_file *curr) {
+	source_file source;
+	char *input_filename = strallocat(curr->filename, ".as");
+	FILE *file_desc = fopen(input_filename, "r");
+	bool is_success = file_desc != NULL && read_source(&source, file_desc);
+	if (file_desc != NULL) {
+		curr->lines = source.line_count;
+		free_source(&source);
+		fclose(file_desc);
+	}
+	free(input_filename);
+	return is_success;
+}
+
+/**
+ * Reads the count of words of an output, from the top of it's .ob file
+ * @param curr The file - it's count of words is set (0 if it wasn't assembled)
+ */
+static void count_words(bench_file *curr) {
+	long code_length = 0, data_length = 0;
+	char *output_filename = strallocat(curr->filename, ".ob");
+	FILE *file_desc = fopen(output_filename, "r");
+	curr->words = 0;
+	if (file_desc != NULL) {
+		if (fscanf(file_desc, "%ld %ld", &code_length, &data_length) == 2) curr->words = code_length + data_length;
+		fclose(file_desc);
+	}
+	free(output_filename);
+}
+
+/**
+ * Removes the .ob file of a source, so it's only there if the source is assembled again
+ * @param curr The file
+ */
+static void remove_output(bench_file *curr) {
+	char *output_filename = strallocat(curr->filename, ".ob");
+	remove(output_filename);
+	free(output_filename);
+}
+
+/**
+ * Compares two latencies, for sorting
+ */
+static int compare_latencies(const void *first, const void *second) {
+	double difference = *(const double *) first - *(const double *) second;
+	return difference < 0 ? -1 : difference > 0;
+}
+
+/**
+ * Returns a percentile of sorted latencies (nearest rank)
+ * @param latencies The latencies, sorted
+ * @param count The count of latencies
+ * @param percent The percentile
+ * @return The latency
+ */
+static double percentile(double *latencies, long count, int percent) {
+	long rank = (count * percent + 99) / 100;
+	return latencies[rank < 1 ? 0 : rank - 1];
+}
+
+/**
+ * Entry point - benchmarks the assembler in the arguments over the files that follow it
+ */
+int main(int argc, char *argv[]) {
+	int i, repeats = 1;
+	long j, file_count = 0, assembled = 0, total_lines = 0, total_words = 0, sample_count = 0;
+	char *assembler = NULL, *workers = NULL, *end, **arguments;
+	double start, elapsed, *latencies;
+	bench_file *files = calloc_with_check(argc * sizeof(bench_file));
+
+	/* Collect the workers of the batch run (-j N), the runs of each file (-r N), the assembler and the files */
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) workers = argv[++i];
+		else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			repeats = (int) strtol(argv[++i], &end, 10);
+			if (repeats < 1 || *end != '\0') {
+				printf("Error: -r expects a positive count of runs.\n");
+				free(files);
+				return 1;
+			}
+		} else if (assembler == NULL) assembler = argv[i];
+		else {
+			/* Like the assembler, the extension is dropped */
+			files[file_count].filename = calloc_with_check(strlen(argv[i]) + 1);
+			strncpy(files[file_count].filename, argv[i], strlen(argv[i]) - (strlen(argv[i]) > 3 &&
+			        strcmp(argv[i] + strlen(argv[i]) - 3, ".as") == 0 ? 3 : 0));
+			if (!count_lines(&files[file_count])) {
+				printf("Error: file \"%s\" is inaccessible for reading.\n", argv[i]);
+				free(files);
+				return 1;
+			}
+			total_lines += files[file_count++].lines;
+		}
+	}
+	if (file_count == 0) {
+		printf("Usage: %s [-j workers] [-r runs] assembler file.as...\n", argv[0]);
+		free(files);
+		return 1;
+	}
+
+	/* The whole corpus at once - the throughput */
+	arguments = calloc_with_check((file_count + 4) * sizeof(char *));
+	arguments[0] = assembler;
+	i = 1;
+	if (workers != NULL) {
+		arguments[i++] = "-j";
+		arguments[i++] = workers;
+	}
+	for (j = 0; j < file_count; j++) {
+		arguments[i + j] = files[j].filename;
+		remove_output(&files[j]);
+	}
+	start = now();
+	if (!run_quietly(arguments)) {
+		printf("Error: Failed to run %s.\n", assembler);
+		free(arguments);
+		free(files);
+		return 1;
+	}
+	elapsed = now() - start;
+	for (j = 0; j < file_count; j++) {
+		count_words(&files[j]);
+		total_words += files[j].words;
+		if (files[j].words > 0) assembled++;
+	}
+
+	/* Each file alone - the latency */
+	latencies = calloc_with_check(file_count * repeats * sizeof(double));
+	arguments[2] = NULL;
+	for (j = 0; j < file_count; j++) {
+		arguments[1] = files[j].filename;
+		for (i = 0; i < repeats; i++) {
+			start = now();
+			run_quietly(arguments);
+			latencies[sample_count++] = (now() - start) * 1000;
+		}
+	}
+	qsort(latencies, sample_count, sizeof(double), compare_latencies);
+
+	printf("Files: %ld (%ld assembled), lines: %ld, words: %ld\n", file_count, assembled, total_lines, total_words);
+	printf("All at once%s%s: %.3f s, %.0f lines/s, %.0f words/s\n", workers != NULL ? " with -j " : "",
+	       workers != NULL ? workers : "", elapsed, total_lines / elapsed, total_words / elapsed);
+	printf("Latency of a file (ms, %ld runs): p50 %.2f, p90 %.2f, p99 %.2f, max %.2f\n", sample_count,
+	       percentile(latencies, sample_count, 50), percentile(latencies, sample_count, 90),
+	       percentile(latencies, sample_count, 99), latencies[sample_count - 1]);
+
+	for (j = 0; j < file_count; j++) free(files[j].filename);
+	free(latencies);
+	free(arguments);
+	free(files);
+	return 0;
+}
@@ -0,0 +1,136 @@
+/* Implements the cache of output files. Each cached source is a single file in the cache directory, named by it's key,
+ * holding all the source's output files one after the other: "<extension> <length>\n<content>" for each. */
+/* mkdir, for creating the cache directory */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "cache.h"
+#include "writefiles.h"
+#include "utils.h"
+#include "version.h"
+
+/** Extension of the cache files */
+#define CACHE_EXTENSION ".cache"
+
+/** Max length of a cached output's header (extension and length) */
+#define ENTRY_HEADER_LENGTH 32
+
+bool prepare_cache(char *cache_dir) {
+	struct stat status;
+	if (mkdir(cache_dir, 0777) == 0) return TRUE;
+	return errno == EEXIST && stat(cache_dir, &status) == 0 && S_ISDIR(status.st_mode);
+}
+
+/**
+ * Hashes bytes into two independent hashes (FNV-1a and sdbm), continuing from their current values
+ * @param data The bytes to hash
+ * @param size The count of bytes
+ * @param first The first hash, updated
+ * @param second The second hash, updated
+ */
+static void hash_bytes(char *data, long size, unsigned long *first, unsigned long *second) {
+	unsigned long fnv = *first, sdbm = *second;
+	unsigned char *curr = (unsigned char *) data, *end = curr + size;
+	for (; curr < end; curr++) {
+		fnv = ((fnv ^ *curr) * 16777619UL) & 0xFFFFFFFFUL;
+		sdbm = (*curr + (sdbm << 6) + (sdbm << 16) - sdbm) & 0xFFFFFFFFUL;
+	}
+	*first = fnv;
+	*second = sdbm;
+}
+
+char *cache_key(source_file *source, bool binary) {
+	unsigned long first = 2166136261UL, second = 0;
+	/* Enough for two 32-bit hashes and a long, in hex */
+	char *key = calloc_with_check(8 + 8 + 1 + sizeof(long) * 2 + 1);
+	hash_bytes(ASSEMBLER_VERSION, strlen(ASSEMBLER_VERSION), &first, &second);
+	hash_bytes(binary ? "b" : "t", 1, &first, &second);
+	/* The line breaks of the text are replaced by '\0' - the count of lines tells them from NULs in the file */
+	hash_bytes(source->text, source->size, &first, &second);
+	sprintf(key, "%08lx%08lx-%lx", first, second, (unsigned long) source->line_count);
+	return key;
+}
+
+/**
+ * Returns the path of a cache file, without the extension
+ * @param cache_dir The cache directory
+ * @param key The key
+ * @return A new string of the path
+ */
+static char *cache_path(char *cache_dir, char *key) {
+	char *dir = strallocat(cache_dir, "/");
+	char *path = strallocat(dir, key);
+	free(dir);
+	return path;
+}
+
+bool restore_from_cache(char *cache_dir, char *key, char *filename, FILE *output) {
+	int i;
+	long size, length;
+	char *data = NULL, *curr, *end, *path = cache_path(cache_dir, key), *full_path;
+	bool is_success;
+	FILE *file_desc;
+	full_path = strallocat(path, CACHE_EXTENSION);
+	file_desc = fopen(full_path, "rb");
+	free(full_path);
+	is_success = file_desc != NULL && read_whole_file(file_desc, &data, &size);
+	if (file_desc != NULL) fclose(file_desc);
+
+	/* Validate the whole cache file first, so the outputs are restored all or none */
+	for (i = 0, curr = data; is_success && curr < data + size; i++) {
+		length = strlen(output_extensions[i % OUTPUT_COUNT(TRUE)]);
+		is_success = i < OUTPUT_COUNT(TRUE) && strncmp(curr, output_extensions[i], length) == 0 && curr[length] == ' ';
+		if (is_success) {
+			length = strtol(curr + length + 1, &end, 10);
+			is_success = *end == '\n' && length >= 0 && length <= data + size - (end + 1);
+			curr = end + 1 + length;
+		}
+	}
+	is_success = is_success && (i == OUTPUT_COUNT(FALSE) || i == OUTPUT_COUNT(TRUE));
+
+	for (i = 0, curr = data; is_success && curr < data + size; i++) {
+		length = strtol(curr + strlen(output_extensions[i]) + 1, &end, 10);
+		is_success = write_buffer_to_file(end + 1, length, filename, output_extensions[i], output);
+		curr = end + 1 + length;
+	}
+	free(data);
+	free(path);
+	return is_success;
+}
+
+bool store_in_cache(char *cache_dir, char *key, char *filename, bool binary, FILE *output) {
+	int i;
+	long sizes[OUTPUT_COUNT(TRUE)], total = 0;
+	char *contents[OUTPUT_COUNT(TRUE)], *data, *curr, *path;
+	bool is_success = TRUE;
+	FILE *file_desc;
+	/* Read back the outputs, which were just written */
+	for (i = 0; i < OUTPUT_COUNT(binary); i++) {
+		path = strallocat(filename, output_extensions[i]);
+		contents[i] = NULL;
+		sizes[i] = 0;
+		file_desc = fopen(path, "rb");
+		if (file_desc == NULL || !read_whole_file(file_desc, &contents[i], &sizes[i])) is_success = FALSE;
+		if (file_desc != NULL) fclose(file_desc);
+		total += sizes[i] + ENTRY_HEADER_LENGTH;
+		free(path);
+	}
+	if (is_success) {
+		curr = data = calloc_with_check(total + 1);
+		for (i = 0; i < OUTPUT_COUNT(binary); i++) {
+			curr += sprintf(curr, "%s %ld\n", output_extensions[i], sizes[i]);
+			memcpy(curr, contents[i], sizes[i]);
+			curr += sizes[i];
+		}
+		path = cache_path(cache_dir, key);
+		is_success = write_buffer_to_file(data, curr - data, path, CACHE_EXTENSION, output);
+		free(path);
+		free(data);
+	}
+	for (i = 0; i < OUTPUT_COUNT(binary); i++) free(contents[i]);
+	return is_success;
+}
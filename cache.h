@@ -0,0 +1,44 @@
+/* Implements a content-addressed cache of the output files, keyed by the source and the assembler version */
+#ifndef _CACHE_H
+#define _CACHE_H
+#include <stdio.h>
+#include "globals.h"
+#include "source.h"
+
+/**
+ * Makes sure the cache directory exists, and creates it if not
+ * @param cache_dir The cache directory
+ * @return Whether the directory exists
+ */
+bool prepare_cache(char *cache_dir);
+
+/**
+ * Returns the cache key of a source - a hash of it's bytes and of the assembler version
+ * @param source The source, already read
+ * @param binary Whether the binary object is written as well
+ * @return A new string of the key
+ */
+char *cache_key(source_file *source, bool binary);
+
+/**
+ * Restores the output files of a source from the cache. Files that wouldn't change aren't rewritten.
+ * @param cache_dir The cache directory
+ * @param key The cache key of the source
+ * @param filename The filename of the outputs, without the extension
+ * @param output The stream to print the errors to
+ * @return Whether the outputs were found in the cache and restored
+ */
+bool restore_from_cache(char *cache_dir, char *key, char *filename, FILE *output);
+
+/**
+ * Stores the output files of a source, which were just written, in the cache
+ * @param cache_dir The cache directory
+ * @param key The cache key of the source
+ * @param filename The filename of the outputs, without the extension
+ * @param binary Whether the binary object was written as well
+ * @param output The stream to print the errors to
+ * @return Whether succeeded
+ */
+bool store_in_cache(char *cache_dir, char *key, char *filename, bool binary, FILE *output);
+
+#endif
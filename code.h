@@ -3,59 +3,61 @@
 #define _CODE_H
 #include "table.h"
 #include "globals.h"
-
-/**
- * Detects the opcode and the funct of a command by it's name
- * @param cmd The command name (string)
- * @param opcode_out The opcode value destination
- * @param funct_out The funct value destination
- */
-void get_opcode_func(char* cmd, opcode *opcode_out, funct *funct_out);
+#include "arena.h"
+#include "ir.h"
+#include "names.h"
+#include "isa.h"
+#include "lexer.h"
 
 /**
  * Returns the addressing type of an operand
- * @param operand The operand's string
+ * @param operand The operand's text
+ * @param length The length of the operand's text
  * @return The addressing type of the operand
  */
-addressing_type get_addressing_type(char *operand);
+addressing_type get_addressing_type(char *operand, int length);
 
 /**
- * Validates and Builds a code word by the opcode, funct, operand count and operand strings
- * @param curr_opcode The current opcode
- * @param curr_funct The current funct
- * @param op_count The operands count
- * @param operands a 2-cell array of pointers to first and second operands.
- * @return A pointer to code word struct, which represents the code. if validation fails, returns NULL.
+ * Classifies an operand by the kind of it's token, and parses it's value
+ * @param content The line of the token
+ * @param token The operand's token
+ * @param names The names table, to get the id of a symbol from
+ * @return The classified operand. Addressing is NONE_ADDR if the operand is invalid.
  */
-code_word *get_code_word(line_info line, opcode curr_opcode, funct curr_funct, int op_count, char *operands[2]);
+operand classify_operand(char *content, lex_token *token, name_table *names);
 
 /**
- * Returns the register enum value by it's name
- * @param name The name of the register
- * @return The enum value of the register if found. otherwise, returns NONE_REG
+ * Validates and Builds a code word by the operation, operand count and the classified operands
+ * @param line The current source line info
+ * @param operation The operation, from the instruction set table
+ * @param op_count The operands count
+ * @param operands a 2-cell array of the first and second operands.
+ * @param mem The arena to allocate the code word from
+ * @return A pointer to code word struct, which represents the code. if validation fails, returns NULL.
  */
-reg get_register_by_name(char *name);
+code_word *get_code_word(line_info line, isa_operation *operation, int op_count, operand operands[2], arena *mem);
 
 /**
  * Builds a data word by the operand's addressing type, value and whether the symbol (if it is one) is external.
  * @param addressing The addressing type of the value
  * @param data The value
  * @param is_extern_symbol If the symbol is a label, and it's external
+ * @param mem The arena to allocate the data word from
  * @return A pointer to the constructed data word for the data by the specified properties.
  */
-data_word *build_data_word(addressing_type addressing, long data, bool is_extern_symbol);
+data_word *build_data_word(addressing_type addressing, long data, bool is_extern_symbol, arena *mem);
 
 /**
- * Separates the operands from a certain index, puts each operand into the destination array,
- * and puts the found operand count in operand count argument
+ * Separates the operands from the tokens after the command, puts the token of each operand into the destination array,
+ * and puts the found operand count in operand count argument. Nothing is copied or allocated.
  * @param line The command text
- * @param i The index to start analyzing from
- * @param destination At least a 2-cell buffer of strings for the extracted operand strings
+ * @param token The first token after the command
+ * @param end The end of the line's tokens
+ * @param destination A 2-cell array for the tokens of the operands
  * @param operand_count The destination of the detected operands count
- * @param command The current command string
  * @return Whether analyzing succeeded
  */
-bool analyze_operands(line_info line, int i, char **destination, int *operand_count, char *command);
+bool analyze_operands(line_info line, lex_token *token, lex_token *end, lex_token *destination[2], int *operand_count);
 
 /**
  * Merge Data image and code image to memory image, the data image insert at the end of memory image
@@ -63,7 +65,8 @@ bool analyze_operands(line_info line, int i, char **destination, int *operand_co
  * @param data_img The data image
  * @param icf The last address index of instruction in code image
  * @param dcf The last address index of data image
+ * @param mem The arena to allocate the data words from
  */
-void merge_data_and_code_img(machine_word** memory_img, long* data_img, long icf, long dcf);
+void merge_data_and_code_img(machine_word** memory_img, long* data_img, long icf, long dcf, arena *mem);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,364 @@
+/* Generates a deterministic corpus of synthetic assembly sources, for benchmarking the assembler */
+/* mkdir, for creating the corpus directory */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "globals.h"
+#include "isa.h"
+#include "utils.h"
+
+/** Percentages are given in per-mille, for finer control of the rare lines */
+#define PER_MILLE 1000
+
+/** Maximum count of values of a single .data line, and of chars of a single .string line */
+#define MAX_DATA_VALUES 8
+#define MAX_STRING_LENGTH 24
+
+/** The shape of the generated sources */
+typedef struct corpus_options {
+	/** Where to write the sources, how many, and how many lines each */
+	char *directory;
+	long file_count;
+	long line_count;
+	/** Seed of the random generator - the same options always generate the same corpus */
+	unsigned long seed;
+	/** Weight of each operation, in the instruction mix */
+	long weights[ISA_COUNT];
+	/** Per-mille of the lines which have a label */
+	long label_rate;
+	/** Per-mille of the lines which are .data/.string, and of them which are .string */
+	long directive_rate;
+	long string_rate;
+	/** Count of the .extern and .entry symbols of each file */
+	long extern_count;
+	long entry_count;
+	/** Per-mille of the lines which have an error */
+	long error_rate;
+} corpus_options;
+
+/** The state of a single generated source */
+typedef struct generator {
+	corpus_options *options;
+	unsigned long random;
+	/** Whether each line is a directive, and whether it has a label */
+	bool *is_directive;
+	bool *has_label;
+	/** The lines which have a code label */
+	long *code_labels;
+	long code_label_count;
+	/** The lines which have a data label */
+	long *data_labels;
+	long data_label_count;
+} generator;
+
+/**
+ * Returns the next random number of the generator (xorshift)
+ * @param gen The generator
+ * @param bound The count of possible numbers
+ * @return A number from 0 to bound-1
+ */
+static long next_random(generator *gen, long bound) {
+	unsigned long x = gen->random;
+	x ^= (x << 13) & 0xFFFFFFFFUL;
+	x ^= x >> 17;
+	x ^= (x << 5) & 0xFFFFFFFFUL;
+	gen->random = x;
+	return (long) (x % (unsigned long) bound);
+}
+
+/**
+ * Returns whether an event of a given rate happens now
+ * @param gen The generator
+ * @param rate The rate of the event, in per-mille
+ * @return Whether it happens
+ */
+static bool chance(generator *gen, long rate) {
+	return next_random(gen, PER_MILLE) < rate;
+}
+
+/**
+ * Writes the name of the label of a line
+ * @param file The file to write to
+ * @param line The line
+ * @param is_directive Whether the line is a directive (a data label)
+ */
+static void put_label_name(FILE *file, long line, bool is_directive) {
+	fprintf(file, "%c%ld", is_directive ? 'D' : 'L', line);
+}
+
+/**
+ * Writes a random operand of an allowed addressing mode
+ * @param gen The generator
+ * @param file The file to write to
+ * @param modes The allowed addressing modes
+ */
+static void put_operand(generator *gen, FILE *file, unsigned int modes) {
+	int addressing;
+	long line;
+	/* Choose one of the allowed modes - there's at least one */
+	do {
+		addressing = (int) next_random(gen, 4);
+	} while (!(modes & MODE(addressing)));
+	/* Relative addressing needs a code label, and direct addressing needs any label or external */
+	if (addressing == RELATIVE_ADDR && gen->code_label_count == 0) addressing = DIRECT_ADDR;
+	if (addressing == DIRECT_ADDR && gen->code_label_count + gen->data_label_count == 0 &&
+	    gen->options->extern_count == 0) {
+		addressing = (modes & REGISTER_MODE) ? REGISTER_ADDR : IMMEDIATE_ADDR;
+	}
+	switch (addressing) {
+		case IMMEDIATE_ADDR:
+			fprintf(file, "#%ld", next_random(gen, 4096) - 2048);
+			break;
+		case REGISTER_ADDR:
+			fprintf(file, "r%ld", next_random(gen, 8));
+			break;
+		case RELATIVE_ADDR:
+			line = gen->code_labels[next_random(gen, gen->code_label_count)];
+			fputc('%', file);
+			put_label_name(file, line, FALSE);
+			break;
+		default: /* Direct - an external (a fifth of the times, if any), or a label */
+			if (gen->options->extern_count > 0 &&
+			    (gen->code_label_count + gen->data_label_count == 0 || next_random(gen, 5) == 0)) {
+				fprintf(file, "X%ld", next_random(gen, gen->options->extern_count));
+			} else {
+				line = next_random(gen, gen->code_label_count + gen->data_label_count);
+				if (line < gen->code_label_count) put_label_name(file, gen->code_labels[line], FALSE);
+				else put_label_name(file, gen->data_labels[line - gen->code_label_count], TRUE);
+			}
+			break;
+	}
+}
+
+/**
+ * Writes a random operation, by the instruction mix
+ * @param gen The generator
+ * @param file The file to write to
+ */
+static void put_operation(generator *gen, FILE *file) {
+	long i, total = 0, choice;
+	isa_operation *operation;
+	for (i = 0; i < ISA_COUNT; i++) total += gen->options->weights[i];
+	choice = next_random(gen, total);
+	for (i = 0; choice >= gen->options->weights[i]; i++) choice -= gen->options->weights[i];
+	operation = &isa_table[i];
+
+	fprintf(file, "%s", operation->name);
+	if (operation->operand_count == 2) {
+		fputc(' ', file);
+		put_operand(gen, file, operation->source_modes);
+		fputs(", ", file);
+		put_operand(gen, file, operation->destination_modes);
+	} else if (operation->operand_count == 1) {
+		fputc(' ', file);
+		put_operand(gen, file, operation->destination_modes);
+	}
+}
+
+/**
+ * Writes a random .data or .string directive
+ * @param gen The generator
+ * @param file The file to write to
+ */
+static void put_directive(generator *gen, FILE *file) {
+	long i, count;
+	if (chance(gen, gen->options->string_rate)) {
+		fputs(".string \"", file);
+		for (i = next_random(gen, MAX_STRING_LENGTH) + 1; i > 0; i--) fputc('a' + (int) next_random(gen, 26), file);
+		fputc('"', file);
+	} else {
+		fputs(".data ", file);
+		for (i = 0, count = next_random(gen, MAX_DATA_VALUES) + 1; i < count; i++) {
+			fprintf(file, i == 0 ? "%ld" : ", %ld", next_random(gen, 4096) - 2048);
+		}
+	}
+}
+
+/**
+ * Writes an erroneous line - one of a few kinds of errors
+ * @param gen The generator
+ * @param file The file to write to
+ */
+static void put_error(generator *gen, FILE *file) {
+	switch (next_random(gen, 5)) {
+		case 0:
+			fputs("mvo r1, r2", file); /* Unknown operation */
+			break;
+		case 1:
+			fputs("add r1", file); /* Missing operand */
+			break;
+		case 2:
+			fputs("jmp UNDEFINED_LABEL", file); /* Undefined label */
+			break;
+		case 3:
+			fputs("lea #1, r1", file); /* Invalid addressing */
+			break;
+		default:
+			fputs(".data 1,, 2", file); /* Invalid directive */
+			break;
+	}
+}
+
+/**
+ * Generates a single source file
+ * @param options The shape of the source
+ * @param index The index of the file, which seeds it's random generator (with the corpus seed)
+ * @param filename The file to write to
+ * @return Whether succeeded
+ */
+static bool generate_file(corpus_options *options, long index, char *filename) {
+	long i, body_lines, label_count;
+	generator gen;
+	FILE *file = fopen(filename, "w");
+	if (file == NULL) {
+		printf("Error: Can't create or rewrite to file %s.\n", filename);
+		return FALSE;
+	}
+	gen.options = options;
+	gen.random = ((options->seed * 2654435761UL) ^ (unsigned long) (index + 1) * 40503UL) & 0xFFFFFFFFUL;
+	if (gen.random == 0) gen.random = 1;
+	/* The .extern lines first and the .entry lines last, the rest is the body */
+	body_lines = options->line_count - options->extern_count - options->entry_count;
+	if (body_lines < 1) body_lines = 1;
+	gen.is_directive = calloc_with_check(body_lines * sizeof(bool));
+	gen.has_label = calloc_with_check(body_lines * sizeof(bool));
+	gen.code_labels = calloc_with_check(body_lines * sizeof(long));
+	gen.data_labels = calloc_with_check(body_lines * sizeof(long));
+	gen.code_label_count = gen.data_label_count = 0;
+
+	/* Choose the kind and the label of each line first, so any line can refer to any label. The first is code */
+	for (i = 0; i < body_lines; i++) {
+		gen.is_directive[i] = i > 0 && chance(&gen, options->directive_rate);
+		gen.has_label[i] = i == 0 || chance(&gen, options->label_rate);
+		if (gen.has_label[i] && gen.is_directive[i]) gen.data_labels[gen.data_label_count++] = i;
+		else if (gen.has_label[i]) gen.code_labels[gen.code_label_count++] = i;
+	}
+
+	for (i = 0; i < options->extern_count; i++) fprintf(file, ".extern X%ld\n", i);
+	for (i = 0; i < body_lines; i++) {
+		if (gen.has_label[i]) {
+			put_label_name(file, i, gen.is_directive[i]);
+			fputs(": ", file);
+		} else fputc('\t', file);
+		if (chance(&gen, options->error_rate)) put_error(&gen, file);
+		else if (gen.is_directive[i]) put_directive(&gen, file);
+		else put_operation(&gen, file);
+		fputc('\n', file);
+	}
+	/* Entries of distinct labels, spread over the labels */
+	label_count = gen.code_label_count + gen.data_label_count;
+	for (i = 0; i < options->entry_count && i < label_count; i++) {
+		fputs(".entry ", file);
+		if (i * label_count / options->entry_count < gen.code_label_count) {
+			put_label_name(file, gen.code_labels[i * label_count / options->entry_count], FALSE);
+		} else {
+			put_label_name(file, gen.data_labels[i * label_count / options->entry_count - gen.code_label_count], TRUE);
+		}
+		fputc('\n', file);
+	}
+
+	free(gen.is_directive);
+	free(gen.has_label);
+	free(gen.code_labels);
+	free(gen.data_labels);
+	return fclose(file) == 0;
+}
+
+/**
+ * Sets the weight of an operation in the mix, from a "name=weight" argument
+ * @param options The options
+ * @param argument The argument
+ * @return Whether the argument is valid
+ */
+static bool set_weight(corpus_options *options, char *argument) {
+	int i;
+	char *end, *separator = strchr(argument, '=');
+	if (separator == NULL) return FALSE;
+	for (i = 0; i < ISA_COUNT; i++) {
+		if (strlen(isa_table[i].name) == (size_t) (separator - argument) &&
+		    strncmp(isa_table[i].name, argument, separator - argument) == 0) {
+			options->weights[i] = strtol(separator + 1, &end, 10);
+			return *end == '\0' && separator[1] != '\0' && options->weights[i] >= 0;
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * Entry point - generates the corpus, by the options in the arguments
+ */
+int main(int argc, char *argv[]) {
+	int i;
+	long total_weight = 0, *value;
+	char *end, *filename, name[32];
+	bool is_success = TRUE;
+	corpus_options options;
+
+	/* Defaults: a uniform mix, a label on every 5th line, a data line for every 4 */
+	options.directory = "corpus";
+	options.file_count = 10;
+	options.line_count = 1000;
+	options.seed = 1;
+	for (i = 0; i < ISA_COUNT; i++) options.weights[i] = 1;
+	options.label_rate = 200;
+	options.directive_rate = 250;
+	options.string_rate = 300;
+	options.extern_count = 4;
+	options.entry_count = 4;
+	options.error_rate = 0;
+
+	for (i = 1; i < argc; i++) {
+		value = NULL;
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) options.directory = argv[++i];
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			if (!set_weight(&options, argv[++i])) {
+				printf("Error: -w expects an operation and it's weight, e.g. mov=3 (got %s).\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (strcmp(argv[i], "-n") == 0) value = &options.file_count;
+		else if (strcmp(argv[i], "-l") == 0) value = &options.line_count;
+		else if (strcmp(argv[i], "-L") == 0) value = &options.label_rate;
+		else if (strcmp(argv[i], "-d") == 0) value = &options.directive_rate;
+		else if (strcmp(argv[i], "-S") == 0) value = &options.string_rate;
+		else if (strcmp(argv[i], "-x") == 0) value = &options.extern_count;
+		else if (strcmp(argv[i], "-e") == 0) value = &options.entry_count;
+		else if (strcmp(argv[i], "-E") == 0) value = &options.error_rate;
+		else if (strcmp(argv[i], "-s") == 0) {
+			if (++i == argc || (options.seed = strtoul(argv[i], &end, 10), *end != '\0')) {
+				printf("Error: -s expects a seed number.\n");
+				return 1;
+			}
+		} else {
+			printf("Usage: %s [-o dir] [-n files] [-l lines] [-s seed] [-w op=weight]... [-L label_rate]\n"
+			       "       [-d directive_rate] [-S string_rate] [-x externs] [-e entries] [-E error_rate]\n"
+			       "Rates are per-mille.\n", argv[0]);
+			return 1;
+		}
+		if (value != NULL && (++i == argc || (*value = strtol(argv[i], &end, 10), *end != '\0') || *value < 0)) {
+			printf("Error: %s expects a non-negative number.\n", argv[i - 1]);
+			return 1;
+		}
+	}
+	for (i = 0; i < ISA_COUNT; i++) total_weight += options.weights[i];
+	if (total_weight == 0) {
+		printf("Error: At least one operation must have a weight.\n");
+		return 1;
+	}
+	if (mkdir(options.directory, 0777) != 0 && errno != EEXIST) {
+		printf("Error: Can't create the directory %s.\n", options.directory);
+		return 1;
+	}
+
+	for (i = 0; i < options.file_count && is_success; i++) {
+		sprintf(name, "/gen%05d.as", i + 1);
+		filename = strallocat(options.directory, name);
+		is_success = generate_file(&options, i, filename);
+		free(filename);
+	}
+	return is_success ? 0 : 1;
+}
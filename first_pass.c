@@ -1,4 +1,6 @@
 /* Contains major function that are related to the first pass */
+/* open_memstream, for buffering the errors of each chunk */
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,6 +10,33 @@
 #include "utils.h"
 #include "instructions.h"
 #include "first_pass.h"
+#include "pool.h"
+#include "keywords.h"
+#include "lexer.h"
+
+/** A chunk of the source lines, processed into it's own state */
+typedef struct chunk {
+	/** The range of lines of the chunk */
+	long first_line;
+	long end_line;
+	/** The chunk's state, with addresses relative to the chunk's start */
+	fpass_state state;
+	bool is_success;
+	/** The errors the chunk printed, and their count */
+	char *error_text;
+	size_t error_size;
+	error_budget errors;
+} chunk;
+
+/** The chunks of a file's first pass */
+typedef struct chunked_pass {
+	source_file *source;
+	line_info line;
+	chunk *chunks;
+	/** The file's state, which the chunks are merged into */
+	fpass_state *state;
+	bool is_success;
+} chunked_pass;
 
 
 /**
@@ -15,12 +44,18 @@
  * Adds the code build binary structure to the memory_img,
  * encodes immediately-addresses operands and leaves required data word that use labels NULL.
  * @param line The code line to process
- * @param i Where to start processing the line from
+ * @param token The token of the operation's name
+ * @param end The end of the line's tokens
+ * @param label The name id of the line's label, NONE_NAME if none
  * @param ic A pointer to the current instruction counter
  * @param memory_img The code image array
+ * @param ir The IR list, to add the line's record to
+ * @param names The names table of the file
+ * @param mem The arena to allocate the words from
  * @return Whether succeeded or notssss
  */
-static bool process_code(line_info line, int i, long *ic, machine_word **memory_img);
+static bool process_code(line_info line, lex_token *token, lex_token *end, long label, long *ic,
+                         machine_word **memory_img, ir_list *ir, name_table *names, arena *mem);
 
 /**
  * Processes a single line in the first pass
@@ -32,153 +67,180 @@ static bool process_code(line_info line, int i, long *ic, machine_word **memory_
  * @param DC A pointer to the current data counter
  * @param memory_img The code image array
  * @param data_img The data image array
+ * @param ir The IR list, to add the line's record to
+ * @param names The names table of the file
+ * @param mem The arena to allocate the file's structures from
  * @return Whether succeeded.
  */
-bool process_line_fpass(line_info line, long *IC, long *DC, machine_word **memory_img, long *data_img, table *symbol_table) {
-	int i, j;
-	char symbol[MAX_LINE_LENGTH];
+bool process_line_fpass(line_info line, long *IC, long *DC, machine_word **memory_img, long *data_img,
+                        table *symbol_table, ir_list *ir, name_table *names, arena *mem) {
+	int j;
+	long label, dc_before;
+	char symbol[MAX_LINE_LENGTH + 1];
 	instruction instruction;
+	line_ir *curr_ir;
+	token_stream tokens;
+	lex_token *token, *end;
 
-	i = 0;
+	/* Split the line into it's tokens at once - everything below goes over them */
+	lex_line(line.content, line.length, &tokens);
+	token = tokens.tokens;
+	end = tokens.tokens + tokens.count;
 
-	MOVE_TO_NOT_WHITE(line.content, i) /* Move to next non-white char */
-	if (!line.content[i] || line.content[i] == '\n' || line.content[i] == EOF || line.content[i] == ';')
+	if (token == end || token->kind == COMMENT_TOKEN)
 		return TRUE; /* Empty/Comment line - no errors found (of course) */
 
 	/* Check if symbol (*:), stages 1.3-1.5 */
 	/* if tried to define label, but it's invalid, return that an error occurred. */
-	if (find_label(line, symbol)) {
-		return FALSE;
-	}
-
-	/* if illegal name */
-	if (symbol[0] && !is_valid_label_name(symbol)) {
-		printf_line_error(line, "Illegal label name: %s", symbol);
-		return FALSE;
-	}
-	/* try using strtok instead... */
-	if (symbol[0] != '\0') {
-		for (; line.content[i] != ':'; i++); /* if symbol detected, start analyzing from it's deceleration end */
-		i++;
+	symbol[0] = '\0';
+	if (token->kind == LABEL_DEF_TOKEN) {
+		if (!is_valid_label_name(line.content + token->column, token->length)) {
+			printf_line_error(line,
+			                  "Invalid label name - cannot be longer than 32 chars, may only start with letter be alphanumeric.");
+			return FALSE;
+		}
+		memcpy(symbol, line.content + token->column, token->length);
+		symbol[token->length] = '\0';
+		token++; /* start analyzing from it's deceleration end */
 	}
 
-	MOVE_TO_NOT_WHITE(line.content, i) /* Move to next not-white char */
+	if (token == end) return TRUE; /* Label-only line - skip */
 
-	if (line.content[i] == '\n') return TRUE; /* Label-only line - skip */
+	label = symbol[0] != '\0' ? intern_name(names, symbol) : NONE_NAME;
 
 	/* if already defined as data/external/code and not empty line */
-	if (find_by_types(*symbol_table, symbol, 3, EXTERNAL_SYMBOL, DATA_SYMBOL, CODE_SYMBOL)) {
+	if (find_by_types(*symbol_table, label,
+	                  SYMBOL_MASK(EXTERNAL_SYMBOL) | SYMBOL_MASK(DATA_SYMBOL) | SYMBOL_MASK(CODE_SYMBOL))) {
 		printf_line_error(line, "Symbol %s is already defined.", symbol);
 		return FALSE;
 	}
 
 	/* Check if it's an instruction (starting with '.') */
-	instruction = find_instruction_from_index(line, &i);
-
-	if (instruction == ERROR_INST) { /* Syntax error found */
-		return FALSE;
+	instruction = NONE_INST;
+	if (token->kind == DIRECTIVE_TOKEN) {
+		/* if invalid instruction but starts with ., it's an error */
+		if (token->keyword.kind != DIRECTIVE_KEYWORD) {
+			printf_line_error(line, "Invalid instruction name: %.*s", token->length, line.content + token->column);
+			return FALSE;
+		}
+		instruction = token->keyword.directive;
+		token++;
 	}
 
-	MOVE_TO_NOT_WHITE(line.content, i)
-
 	/* is it's an instruction */
 	if (instruction != NONE_INST) {
 		/* if .string or .data, and symbol defined, put it into the symbol table */
 		if ((instruction == DATA_INST || instruction == STRING_INST) && symbol[0] != '\0')
 			/* is data or string, add DC with the symbol to the table as data */
-			add_table_item(symbol_table, symbol, *DC, DATA_SYMBOL);
-
-		/* if string, encode into data image buffer and increase dc as needed. */
-		if (instruction == STRING_INST)
-			return process_string_instruction(line, i, data_img, DC);
-			/* if .data, do same but parse numbers. */
-		else if (instruction == DATA_INST)
-			return process_data_instruction(line, i, data_img, DC);
+			add_table_item(symbol_table, label, *DC, DATA_SYMBOL);
+
+		/* if string or .data, encode into data image buffer and increase dc as needed. */
+		if (instruction == STRING_INST || instruction == DATA_INST) {
+			dc_before = *DC;
+			if (instruction == STRING_INST ? !process_string_instruction(line, token, end, data_img, DC)
+			                               : !process_data_instruction(line, token, end, data_img, DC))
+				return FALSE;
+			curr_ir = add_ir_line(ir, DATA_LINE, line.line_number, label);
+			curr_ir->address = dc_before;
+			curr_ir->length = *DC - dc_before;
+		}
 			/* if .extern, add to externals symbol table */
 		else if (instruction == EXTERN_INST) {
-			MOVE_TO_NOT_WHITE(line.content, i)
-	
-			/* if external symbol detected, start analyzing from it's deceleration end */
-			for (j = 0; line.content[i] && line.content[i] != '\n' && line.content[i] != '\t' && line.content[i] != ' ' && line.content[i] != EOF; i++, j++) {
-				symbol[j] = line.content[i];
-			}
+			/* The external symbol is the token after the directive, if there's one */
+			j = token < end ? token->length : 0;
+			memcpy(symbol, line.content + (token < end ? token->column : 0), j);
 			symbol[j] = 0;
 			/* If invalid external label name, it's an error */
-			if (!(symbol[0] && strlen(symbol) < 32 && isalpha(symbol[0]) && is_alphanumeric_str(symbol + 1))) {
+			if (!(j > 0 && j <= MAX_LABEL_LENGTH && isalpha(symbol[0]) && is_alphanumeric_str(symbol + 1, j - 1))) {
 				printf_line_error(line, "Invalid external label name: %s", symbol);
 				return FALSE;
 			}
-			add_table_item(symbol_table, symbol, 0, EXTERNAL_SYMBOL); /* Extern value is defaulted to 0 */
+			curr_ir = add_ir_line(ir, EXTERN_LINE, line.line_number, label);
+			curr_ir->operand_count = 1;
+			curr_ir->operands[0].addressing = DIRECT_ADDR;
+			curr_ir->operands[0].value = intern_name(names, symbol);
+			/* Extern value is defaulted to 0 */
+			add_table_item(symbol_table, curr_ir->operands[0].value, 0, EXTERNAL_SYMBOL);
 		}
 			/* if entry and symbol defined, print error */
 		else if (instruction == ENTRY_INST && symbol[0] != '\0') {
 			printf_line_error(line, "Can't define a label to an entry instruction.");
 			return FALSE;
 		}
-		/* .entry is handled in second pass! */
+		/* .entry is resolved in second pass! just keep the symbol name */
+		else if (instruction == ENTRY_INST) {
+			j = token < end ? token->length : 0;
+			memcpy(symbol, line.content + (token < end ? token->column : 0), j);
+			symbol[j] = 0;
+			curr_ir = add_ir_line(ir, ENTRY_LINE, line.line_number, label);
+			curr_ir->operand_count = 1;
+			curr_ir->operands[0].addressing = DIRECT_ADDR;
+			curr_ir->operands[0].value = intern_name(names, symbol);
+		}
 	} /* end if (instruction != NONE) */
 		/* not instruction=>it's a command! */
 	else {
 		/* if symbol defined, add it to the table */
 		if (symbol[0] != '\0')
-			add_table_item(symbol_table, symbol, *IC, CODE_SYMBOL);
+			add_table_item(symbol_table, label, *IC, CODE_SYMBOL);
 		/* Analyze code */
-		return process_code(line, i, IC, memory_img);
+		return process_code(line, token, end, label, IC, memory_img, ir, names, mem);
 	}
 	return TRUE;
 }
 
 /**
- * Allocates and builds the data inside the additional code word by the given operand,
+ * Allocates and builds the data inside the additional code word by the given operand.
+ * Operands that use a symbol are left NULL, to be built when resolving the IR in the second pass.
  * Only in the first pass
  * @param memory_img The current code image
  * @param ic The current instruction counter
- * @param operand The operand to check
+ * @param op The classified operand
+ * @param mem The arena to allocate the word from
  */
-static void build_extra_codeword_fpass(machine_word **memory_img, long *ic, char *operand);
+static void build_extra_codeword_fpass(machine_word **memory_img, long *ic, operand op, arena *mem);
 
 /**
  * Processes a single code line in the first pass.
  * Adds the code build binary structure to the memory_img,
  * encodes immediately-addresses operands and leaves required data word that use labels NULL.
- * @param line The code line to process
- * @param i Where to start processing the line from
- * @param ic A pointer to the current instruction counter
- * @param memory_img The code image array
- * @return Whether succeeded or notssss
+ * Adds the line's IR record, with the classified operands.
  */
-static bool process_code(line_info line, int i, long *ic, machine_word **memory_img) {
-	char operation[8]; /* stores the string of the current code instruction */
-	char *operands[2]; /* 2 strings, each for operand */
-	opcode curr_opcode; /* the current opcode and funct values */
-	funct curr_funct;
+static bool process_code(line_info line, lex_token *token, lex_token *end, long label, long *ic,
+                         machine_word **memory_img, ir_list *ir, name_table *names, arena *mem) {
+	lex_token *operand_tokens[2]; /* 2 tokens of the line, each for operand */
+	operand operands[2]; /* the classified operands */
+	keyword operation_keyword; /* the current operation, from the instruction set table */
 	code_word *codeword; /* The current code word */
 	long ic_before;
 	int j, operand_count;
 	machine_word *word_to_write;
-	/* Skip white chars */
-	MOVE_TO_NOT_WHITE(line.content, i)
-
-	/* Until white char, end of line, or too big instruction, copy it: */
-	for (j = 0; line.content[i] && line.content[i] != '\t' && line.content[i] != ' ' && line.content[i] != '\n' && line.content[i] != EOF && j < 6; i++, j++) {
-		operation[j] = line.content[i];
-	}
-	operation[j] = '\0'; /* End of string */
-	/* Get opcode & funct by command name into curr_opcode/curr_funct */
-	get_opcode_func(operation, &curr_opcode, &curr_funct);
-	/* If invalid operation (opcode is NONE_OP=-1), print and skip processing the line. */
-	if (curr_opcode == NONE_OP) {
-		printf_line_error(line, "Unrecognized instruction: %s.", operation);
+	line_ir *curr_ir;
+	/* The operation, as the lexer classified the command name */
+	operation_keyword = token->keyword;
+	/* If invalid operation, print (up to 6 chars of it) and skip processing the line. */
+	if (operation_keyword.kind != OPERATION_KEYWORD) {
+		printf_line_error(line, "Unrecognized instruction: %.*s.", token->length > 6 ? 6 : token->length,
+		                  line.content + token->column);
 		return FALSE; /* an error occurred */
 	}
 
 	/* Separate operands and get their count */
-	if (!analyze_operands(line, i, operands, &operand_count, operation))  {
+	if (!analyze_operands(line, token + 1, end, operand_tokens, &operand_count))  {
 		return FALSE;
 	}
 
+	/* Classify each operand once - the code word, the extra words and the IR all use the result */
+	for (j = 0; j < 2; j++) {
+		if (j < operand_count) operands[j] = classify_operand(line.content, operand_tokens[j], names);
+		else {
+			operands[j].addressing = NONE_ADDR;
+			operands[j].value = NONE_NAME;
+		}
+	}
+
 	/* Build code word struct to store in code image array */
-	if ((codeword = get_code_word(line, curr_opcode, curr_funct, operand_count, operands)) == NULL) {
+	if ((codeword = get_code_word(line, operation_keyword.operation, operand_count, operands, mem)) == NULL) {
 		return FALSE;
 	}
 
@@ -186,47 +248,267 @@ static bool process_code(line_info line, int i, long *ic, machine_word **memory_
 	ic_before = *ic;
 
 	/* allocate memory for a new word in the code image, and put the code word into it */
-	word_to_write = (machine_word *) calloc_with_check(sizeof(machine_word));
+	word_to_write = (machine_word *) arena_alloc(mem, sizeof(machine_word));
 	(word_to_write->word).code = codeword;
 	memory_img[(*ic) - IC_INIT_VALUE] = word_to_write; /* Avoid "spending" cells of the array, by starting from initial value of ic */
 
-	/* Build extra information code word if possible, free pointers with no need */
-	if (operand_count--) { /* If there's 1 operand at least */
-		build_extra_codeword_fpass(memory_img, ic, operands[0]);
-		free(operands[0]);
-		if (operand_count) { /* If there are 2 operands */
-			build_extra_codeword_fpass(memory_img, ic, operands[1]);
-			free(operands[1]);
-		}
+	/* Build extra information code word if possible - a word for each operand of the operation */
+	for (j = 0; j < operation_keyword.operation->operand_count; j++) {
+		build_extra_codeword_fpass(memory_img, ic, operands[j], mem);
 	}
 
 	(*ic)++; /* increase ic to point the next cell */
 	/* Add the final length (of code word + data words) to the code word struct: */
 	memory_img[ic_before - IC_INIT_VALUE]->length = (*ic) - ic_before;
 
+	/* Record the line, so the second pass won't have to parse it again */
+	curr_ir = add_ir_line(ir, CODE_LINE, line.line_number, label);
+	curr_ir->address = ic_before;
+	curr_ir->length = (*ic) - ic_before;
+	curr_ir->opcode = operation_keyword.operation->opcode;
+	curr_ir->funct = operation_keyword.operation->funct;
+	curr_ir->operand_count = operand_count;
+	curr_ir->operands[0] = operands[0];
+	curr_ir->operands[1] = operands[1];
+
 	return TRUE; /* No errors */
 }
 
-static void build_extra_codeword_fpass(machine_word **memory_img, long *ic, char *operand) {
-	addressing_type operand_addressing = get_addressing_type(operand);
-	machine_word* word_to_write;
-	char* ptr;
+static void build_extra_codeword_fpass(machine_word **memory_img, long *ic, operand op, arena *mem) {
+	machine_word *word_to_write;
 	/* And again - if another data word is required, increase CI. if it's an immediate addressing, encode it. */
-	if (operand_addressing != NONE_ADDR) {
+	if (op.addressing != NONE_ADDR) {
 		(*ic)++;
-		word_to_write = (machine_word*)calloc_with_check(sizeof(machine_word));
-		if (operand_addressing == IMMEDIATE_ADDR) {
-			/* Get value of immediate addressed operand. notice that it starts with #, so we're skipping the # in the call to strtol */
-			long value = strtol(operand + 1, &ptr, 10);
-			word_to_write->length = 0; /* Not Code word! */
-			(word_to_write->word).data = build_data_word(IMMEDIATE_ADDR, value, FALSE);
+		/* if it uses a symbol, the data word is built when resolving the IR */
+		if (op.addressing == DIRECT_ADDR || op.addressing == RELATIVE_ADDR) return;
+		word_to_write = (machine_word *) arena_alloc(mem, sizeof(machine_word));
+		word_to_write->length = 0; /* Not Code word! */
+		/* Immediate and register operands were already parsed into their value when classified */
+		(word_to_write->word).data = build_data_word(op.addressing, op.value, FALSE, mem);
+		memory_img[(*ic) - IC_INIT_VALUE] = word_to_write;
+	}
+}
+
+bool init_fpass_state(fpass_state *state, long line_count, arena *mem) {
+	state->ic = IC_INIT_VALUE;
+	state->dc = 0;
+	state->mem = mem;
+	state->stopped = FALSE;
+	state->chunk_arenas = NULL;
+	state->chunk_count = 0;
+	init_ir(&state->ir, mem);
+	init_names(&state->names, mem);
+	state->symbol_table = create_table(&state->names);
+	/* Allocate the images once, big enough for the lines' code */
+	return init_images(&state->code, &state->data, line_count);
+}
+
+void free_fpass_state(fpass_state *state) {
+	int i;
+	free_images(&state->code, &state->data);
+	free_ir(&state->ir);
+	for (i = 0; i < state->chunk_count; i++) arena_free(&state->chunk_arenas[i]);
+	free(state->chunk_arenas);
+	state->chunk_arenas = NULL;
+	state->chunk_count = 0;
+}
+
+bool process_lines_fpass(source_file *source, long first_line, long end_line, line_info line, fpass_state *state) {
+	long line_index;
+	bool is_success = TRUE;
+	/* Go over the lines in place. increase line counter for error printing. */
+	for (line_index = first_line; line_index < end_line; line_index++) {
+		/* Too many errors - don't analyze the rest of the file */
+		if (OUT_OF_ERRORS(line.errors)) {
+			state->stopped = TRUE;
+			return FALSE;
 		}
-		if (operand_addressing == REGISTER_ADDR) {
-			/* Get value of register addressed operand */
-			long value = strtol(operand + 1, &ptr, 10);
-			word_to_write->length = 0; /* Not Code word! */
-			word_to_write->word.data = build_data_word(REGISTER_ADDR, value, FALSE);
+		line.line_number = line_index + 1;
+		line.content = source_line(source, line_index);
+		line.length = source_line_length(source, line_index);
+		if (line.length > MAX_LINE_LENGTH) {
+			/* Print message and prevent further line processing, as well as second pass.  */
+			printf_line_error(line, "Line too long to process. Maximum line length should be %d.", MAX_LINE_LENGTH);
+			is_success = FALSE;
+		} else if (!reserve_code_image(&state->code, state->ic - IC_INIT_VALUE + 3) ||
+		           !reserve_data_image(&state->data, state->dc + MAX_LINE_LENGTH)) {
+			/* A line is at most 3 code words, or a data word per char - no room for that, so stop right here. */
+			printf_line_error(line, "Memory image overflow: can't grow the image beyond %ld code and %ld data words.",
+			                  state->code.capacity, state->data.capacity);
+			state->stopped = TRUE;
+			return FALSE;
+		} else if (!process_line_fpass(line, &state->ic, &state->dc, state->code.words, state->data.words,
+		                               &state->symbol_table, &state->ir, &state->names, state->mem)) {
+			is_success = FALSE;
+		}
+	}
+	return is_success;
+}
+
+/**
+ * Processes a single chunk into it's own state - a job of the worker pool
+ * @param job The index of the chunk
+ * @param worker Unused
+ * @param context The chunked pass
+ */
+static void process_chunk(long job, int worker, void *context) {
+	chunked_pass *pass = context;
+	chunk *curr_chunk = &pass->chunks[job];
+	line_info line = pass->line;
+	curr_chunk->error_text = NULL;
+	curr_chunk->error_size = 0;
+	curr_chunk->is_success = FALSE;
+	/* The chunk counts it's own errors, with the file's maximum - it's merged only if the file has room for them */
+	curr_chunk->errors.count = 0;
+	curr_chunk->errors.max = line.errors != NULL ? line.errors->max : 0;
+	line.errors = &curr_chunk->errors;
+	if (!init_fpass_state(&curr_chunk->state, curr_chunk->end_line - curr_chunk->first_line,
+	                      &pass->state->chunk_arenas[job])) {
+		return; /* Processed again in order, which reports the error */
+	}
+	if ((line.error_output = open_memstream(&curr_chunk->error_text, &curr_chunk->error_size)) == NULL) {
+		printf("Error: Fatal: Memory allocation failed.");
+		exit(1);
+	}
+	curr_chunk->is_success = process_lines_fpass(pass->source, curr_chunk->first_line, curr_chunk->end_line, line,
+	                                             &curr_chunk->state);
+	fclose(line.error_output);
+}
+
+/**
+ * Returns whether a chunk can be merged as it is: whether none of the labels it defines were defined before it.
+ * (Only those label checks could have a different result when processing the lines one by one)
+ * @param state The file's state
+ * @param chunk_state The chunk's state
+ * @return Whether the chunk can be merged
+ */
+static bool can_merge_chunk(fpass_state *state, fpass_state *chunk_state) {
+	long i;
+	for (i = 0; i < chunk_state->ir.count; i++) {
+		long label = chunk_state->ir.lines[i].label;
+		/* A name the file doesn't know yet isn't defined in it */
+		if (label != NONE_NAME &&
+		    find_by_types(state->symbol_table, find_name(&state->names, name_by_id(&chunk_state->names, label)),
+		                  SYMBOL_MASK(EXTERNAL_SYMBOL) | SYMBOL_MASK(DATA_SYMBOL) | SYMBOL_MASK(CODE_SYMBOL))) {
+			return FALSE;
+		}
+	}
+	/* Make room for the chunk's words */
+	return reserve_code_image(&state->code, state->ic - IC_INIT_VALUE + (chunk_state->ic - IC_INIT_VALUE)) &&
+	       reserve_data_image(&state->data, state->dc + chunk_state->dc);
+}
+
+/**
+ * Appends a chunk's state to the file's state, moving it's addresses after the file's current IC & DC
+ * @param state The file's state
+ * @param chunk_state The chunk's state
+ */
+static void merge_chunk_state(fpass_state *state, fpass_state *chunk_state) {
+	long i, code_base = state->ic - IC_INIT_VALUE, data_base = state->dc;
+	long *ids = arena_alloc(chunk_state->mem, (chunk_state->names.count + 1) * sizeof(long));
+	table_entry *entry;
+	line_ir *curr_line, *new_line;
+	int j;
+	/* The chunk's name ids, as the file's ids */
+	for (i = 0; i < chunk_state->names.count; i++) {
+		ids[i] = intern_name(&state->names, name_by_id(&chunk_state->names, i));
+	}
+	/* The symbols, by the order they were defined */
+	for (entry = chunk_state->symbol_table->head; entry != NULL; entry = entry->next) {
+		add_table_item(&state->symbol_table, ids[entry->name],
+		               entry->value + (entry->type == CODE_SYMBOL ? code_base : entry->type == DATA_SYMBOL ? data_base : 0),
+		               entry->type);
+	}
+	/* The words - the code words themselves stay in the chunk's arena */
+	memcpy(state->code.words + code_base, chunk_state->code.words,
+	       (chunk_state->ic - IC_INIT_VALUE) * sizeof(machine_word *));
+	memcpy(state->data.words + data_base, chunk_state->data.words, chunk_state->dc * sizeof(long));
+	/* The lines */
+	for (i = 0; i < chunk_state->ir.count; i++) {
+		curr_line = &chunk_state->ir.lines[i];
+		new_line = add_ir_line(&state->ir, curr_line->kind, curr_line->line_number,
+		                       curr_line->label == NONE_NAME ? NONE_NAME : ids[curr_line->label]);
+		new_line->address = curr_line->address + (curr_line->kind == CODE_LINE ? code_base : data_base);
+		new_line->length = curr_line->length;
+		new_line->opcode = curr_line->opcode;
+		new_line->funct = curr_line->funct;
+		new_line->operand_count = curr_line->operand_count;
+		for (j = 0; j < 2; j++) {
+			new_line->operands[j] = curr_line->operands[j];
+			if (j < curr_line->operand_count && (curr_line->operands[j].addressing == DIRECT_ADDR ||
+			                                     curr_line->operands[j].addressing == RELATIVE_ADDR)) {
+				new_line->operands[j].value = ids[curr_line->operands[j].value];
+			}
 		}
-		memory_img[(*ic) - IC_INIT_VALUE] = word_to_write;
 	}
-}
\ No newline at end of file
+	/* The chunk's lookups count as the file's */
+	state->symbol_table->lookups += chunk_state->symbol_table->lookups;
+	state->symbol_table->probes += chunk_state->symbol_table->probes;
+	state->ic += chunk_state->ic - IC_INIT_VALUE;
+	state->dc += chunk_state->dc;
+}
+
+/**
+ * Merges a processed chunk into the file's state, or processes it again in order if it can't be merged.
+ * Called in the chunks order.
+ * @param job The index of the chunk
+ * @param worker Unused
+ * @param context The chunked pass
+ */
+static void merge_chunk(long job, int worker, void *context) {
+	chunked_pass *pass = context;
+	chunk *curr_chunk = &pass->chunks[job];
+	error_budget *errors = pass->line.errors;
+	/* Just like processing the lines one by one, the file stops when it's out of errors */
+	if (!pass->state->stopped && OUT_OF_ERRORS(errors)) {
+		pass->state->stopped = TRUE;
+		pass->is_success = FALSE;
+	}
+	/* If the pass stopped, the rest of the lines are skipped */
+	if (!pass->state->stopped) {
+		if (curr_chunk->is_success && can_merge_chunk(pass->state, &curr_chunk->state) &&
+		    (errors == NULL || errors->max == 0 || errors->count + curr_chunk->errors.count < errors->max)) {
+			merge_chunk_state(pass->state, &curr_chunk->state);
+			/* Errors that didn't fail the line */
+			fwrite(curr_chunk->error_text, 1, curr_chunk->error_size, pass->line.error_output);
+			if (errors != NULL) errors->count += curr_chunk->errors.count;
+		} else if (!process_lines_fpass(pass->source, curr_chunk->first_line, curr_chunk->end_line, pass->line,
+		                                pass->state)) {
+			pass->is_success = FALSE;
+		}
+	}
+	free(curr_chunk->error_text);
+	free_images(&curr_chunk->state.code, &curr_chunk->state.data);
+	free_ir(&curr_chunk->state.ir);
+}
+
+bool first_pass(source_file *source, line_info line, int worker_count, fpass_state *state) {
+	chunked_pass pass;
+	long i, chunk_count;
+	/* A few chunks per worker, so the workers stay busy while the chunks are merged */
+	chunk_count = source->line_count / CHUNK_MIN_LINES;
+	if (chunk_count > worker_count * 4L) chunk_count = worker_count * 4L;
+	/* Collected errors aren't chunked - they're records, not text to merge */
+	if (worker_count <= 1 || chunk_count <= 1 || line.diagnostics != NULL) {
+		return process_lines_fpass(source, 0, source->line_count, line, state);
+	}
+
+	/* Only the assembler program gets here (the library passes a single worker, and collects it's errors), so failing
+	 * to allocate the chunks or their error streams exits the program */
+	pass.source = source;
+	pass.line = line;
+	pass.state = state;
+	pass.is_success = TRUE;
+	pass.chunks = calloc_with_check(chunk_count * sizeof(chunk));
+	state->chunk_arenas = calloc_with_check(chunk_count * sizeof(arena));
+	state->chunk_count = (int) chunk_count;
+	for (i = 0; i < chunk_count; i++) {
+		arena_init(&state->chunk_arenas[i]);
+		/* Line-aligned, and as even as possible */
+		pass.chunks[i].first_line = source->line_count * i / chunk_count;
+		pass.chunks[i].end_line = source->line_count * (i + 1) / chunk_count;
+	}
+	run_jobs(chunk_count, worker_count, process_chunk, merge_chunk, &pass);
+	free(pass.chunks);
+	return pass.is_success;
+}
@@ -2,6 +2,36 @@
 #define _FIRST_PASS_H
 /* Processes a code line in first pass */
 #include "globals.h"
+#include "table.h"
+#include "arena.h"
+#include "ir.h"
+#include "names.h"
+#include "image.h"
+#include "source.h"
+
+/** Minimum count of lines in a chunk, for the first pass to run in parallel chunks */
+#define CHUNK_MIN_LINES 4096
+
+/** Everything the first pass builds - for a whole file, or for a single chunk of it */
+typedef struct fpass_state {
+	/** The instruction & data counters */
+	long ic;
+	long dc;
+	/** The code & data images */
+	code_image code;
+	data_image data;
+	table symbol_table;
+	/** The parsed lines, and the names they refer to */
+	ir_list ir;
+	name_table names;
+	/** The arena to allocate the structures from */
+	arena *mem;
+	/** Whether the pass stopped before the end of the source: an image couldn't grow, or the file is out of errors */
+	bool stopped;
+	/** The arenas of the chunks, which hold some of the code words of the image */
+	arena *chunk_arenas;
+	int chunk_count;
+} fpass_state;
 
 /**
  * Processes a single line in the first pass
@@ -13,9 +43,52 @@
  * @param DC A pointer to the current data counter
  * @param memory_img The code image array
  * @param data_img The data image array
+ * @param ir The IR list, to add the line's record to
+ * @param names The names table of the file
+ * @param mem The arena to allocate the file's structures from
  * @return Whether succeeded.
  */
 bool process_line_fpass(line_info line, long *IC, long *DC, machine_word **memory_img, long *data_img,
-                        table *symbol_table);
+                        table *symbol_table, ir_list *ir, name_table *names, arena *mem);
+
+/**
+ * Initializes an empty first pass state
+ * @param state The state to initialize
+ * @param line_count The count of source lines, to size the images by
+ * @param mem The arena to allocate the state's structures from
+ * @return Whether succeeded (false if the images are too large)
+ */
+bool init_fpass_state(fpass_state *state, long line_count, arena *mem);
+
+/**
+ * Deallocates everything of the state that isn't allocated from it's arena
+ * @param state The state
+ */
+void free_fpass_state(fpass_state *state);
+
+/**
+ * Processes a range of source lines in the first pass, in order
+ * @param source The source file
+ * @param first_line The index of the first line to process
+ * @param end_line The index right after the last line to process
+ * @param line The line info of the file - the file name and the error output
+ * @param state The state to process the lines into
+ * @return Whether succeeded
+ */
+bool process_lines_fpass(source_file *source, long first_line, long end_line, line_info line, fpass_state *state);
+
+/**
+ * Runs the first pass over a whole source file.
+ * Big files are split into line-aligned chunks, which are processed in parallel into their own states.
+ * The chunks are then merged in order, with their addresses moved after the previous chunks'.
+ * A chunk that had errors, or defines a symbol the previous chunks already did, is processed again in order,
+ * so the errors are exactly the same as when processing the lines one by one.
+ * @param source The source file
+ * @param line The line info of the file - the file name and the error output
+ * @param worker_count The count of threads to use
+ * @param state The initialized state of the file
+ * @return Whether succeeded
+ */
+bool first_pass(source_file *source, line_info line, int worker_count, fpass_state *state);
 
 #endif
\ No newline at end of file
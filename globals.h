@@ -2,18 +2,22 @@
 
 #ifndef _GLOBALS_H
 #define _GLOBALS_H
+#include <stdio.h>
 
 /** Boolean (t/f) definition */
 typedef enum booleans {
 	FALSE = 0, TRUE = 1
 } bool;
 
-/** Maximum size of code image and data image */
+/** Minimum allocated size of code image and data image (both grow as needed) */
 #define CODE_ARR_IMG_LENGTH 1200
 
 /** Maximum length of a single source line  */
 #define MAX_LINE_LENGTH 80
 
+/** Maximum length of a label's name */
+#define MAX_LABEL_LENGTH 31
+
 /** Initial IC value */
 #define IC_INIT_VALUE 100
 
@@ -33,58 +37,14 @@ typedef enum addressing_types {
 	NONE_ADDR = -1
 } addressing_type;
 
-/** Commands opcode */
+/** Commands opcode - the opcode of each operation is in it's row of ISA_TABLE (isa.h) */
 typedef enum opcodes {
-	/* First Group */
-	MOV_OP = 0,
-	CMP_OP = 1,
-
-	ADD_OP = 2,
-	SUB_OP = 2,
-
-	LEA_OP = 4,
-	/* END First Group */
-
-	/* Second Group */
-	CLR_OP = 5,
-	NOT_OP = 5,
-	INC_OP = 5,
-	DEC_OP = 5,
-
-	JMP_OP = 9,
-	BNE_OP = 9,
-	JSR_OP = 9,
-
-	RED_OP = 12,
-	PRN_OP = 13,
-	/* END Second Group */
-
-	/* Third Group */
-	RTS_OP = 14,
-	STOP_OP = 15,
-	/* END Third Group */
-
 	/** Failed/Error */
 	NONE_OP = -1
 } opcode;
 
-/** Commands funct */
+/** Commands funct - the funct of each operation is in it's row of ISA_TABLE (isa.h) */
 typedef enum funct {
-	/* OPCODE 2 */
-	ADD_FUNCT = 10,
-	SUB_FUNCT = 11,
-
-	/* OPCODE 5 */
-	CLR_FUNCT = 10,
-	NOT_FUNCT = 11,
-	INC_FUNCT = 12,
-	DEC_FUNCT = 13,
-
-	/* OPCODE 9 */
-	JMP_FUNCT = 10,
-	BNE_FUNCT = 11,
-	JSR_FUNCT = 12,
-
 	/** Default (No need/Error) */
 	NONE_FUNCT = 0
 } funct;
@@ -161,6 +121,16 @@ typedef enum ARE {
 
 } ARE;
 
+/** The errors a file reported, and how many it may report before it stops being analyzed */
+typedef struct error_budget {
+	long count;
+	/** The maximum count of errors (--max-errors), 0 for unlimited */
+	long max;
+} error_budget;
+
+/** Whether a file reported as many errors as it may - errors is an error_budget *, or NULL if not counted */
+#define OUT_OF_ERRORS(errors) ((errors) != NULL && (errors)->max > 0 && (errors)->count >= (errors)->max)
+
 /**
  * Represents a single source line, including it's details
  */
@@ -169,8 +139,16 @@ typedef struct line_info {
 	long line_number;
 	/** File name */
 	char *file_name;
-	/** Line content (source) */
+	/** Line content (source), NUL-terminated without the line break */
 	char *content;
+	/** Length of the line content */
+	long length;
+	/** Stream to print the line's errors to */
+	FILE *error_output;
+	/** The errors of the line's file, counted by each error printed (NULL if not counted) */
+	error_budget *errors;
+	/** Collects the line's errors as records instead of printing them (see utils.h), NULL to print them */
+	struct diagnostic_sink *diagnostics;
 } line_info;
 
 #endif
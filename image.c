@@ -0,0 +1,63 @@
+/* Implements the growable code & data images. Both grow by doubling, so appending is amortized O(1). */
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "image.h"
+
+/**
+ * Returns the capacity to grow to, to hold at least the required length
+ * @param capacity The current capacity
+ * @param length The required length
+ * @param cell_size The size of a single cell, in bytes
+ * @return The new capacity, or -1 if the size in bytes would overflow
+ */
+static long grown_capacity(long capacity, long length, long cell_size) {
+	long max_capacity = LONG_MAX / cell_size;
+	if (length > max_capacity) return -1;
+	if (capacity < CODE_ARR_IMG_LENGTH) capacity = CODE_ARR_IMG_LENGTH;
+	while (capacity < length) {
+		capacity = capacity > max_capacity / 2 ? max_capacity : capacity * 2;
+	}
+	return capacity;
+}
+
+bool init_images(code_image *code, data_image *data, long line_count) {
+	code->words = NULL;
+	data->words = NULL;
+	code->capacity = data->capacity = 0;
+	/* A code line is at most 3 words (code word + 2 operands), so the code image never grows again.
+	 * The data image is just an estimate - most data lines are short. */
+	return reserve_code_image(code, line_count * 3) && reserve_data_image(data, line_count * 2);
+}
+
+bool reserve_code_image(code_image *code, long length) {
+	machine_word **words;
+	long new_capacity;
+	if (length <= code->capacity) return TRUE;
+	if ((new_capacity = grown_capacity(code->capacity, length, sizeof(machine_word *))) < 0) return FALSE;
+	if ((words = realloc(code->words, new_capacity * sizeof(machine_word *))) == NULL) return FALSE;
+	/* New cells are empty */
+	memset(words + code->capacity, 0, (new_capacity - code->capacity) * sizeof(machine_word *));
+	code->words = words;
+	code->capacity = new_capacity;
+	return TRUE;
+}
+
+bool reserve_data_image(data_image *data, long length) {
+	long *words;
+	long new_capacity;
+	if (length <= data->capacity) return TRUE;
+	if ((new_capacity = grown_capacity(data->capacity, length, sizeof(long))) < 0) return FALSE;
+	if ((words = realloc(data->words, new_capacity * sizeof(long))) == NULL) return FALSE;
+	data->words = words;
+	data->capacity = new_capacity;
+	return TRUE;
+}
+
+void free_images(code_image *code, data_image *data) {
+	free(code->words);
+	free(data->words);
+	code->words = NULL;
+	data->words = NULL;
+	code->capacity = data->capacity = 0;
+}
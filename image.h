@@ -0,0 +1,52 @@
+/* Growable code & data images */
+#ifndef _IMAGE_H
+#define _IMAGE_H
+#include "globals.h"
+
+/** The code image - pointers to the machine words, indexed by address - IC_INIT_VALUE */
+typedef struct code_image {
+	machine_word **words;
+	/** Count of cells allocated */
+	long capacity;
+} code_image;
+
+/** The data image - the data values, indexed by DC */
+typedef struct data_image {
+	long *words;
+	/** Count of cells allocated */
+	long capacity;
+} data_image;
+
+/**
+ * Allocates both images, sized by the count of source lines
+ * @param code The code image to initialize
+ * @param data The data image to initialize
+ * @param line_count The count of lines in the source file
+ * @return Whether succeeded
+ */
+bool init_images(code_image *code, data_image *data, long line_count);
+
+/**
+ * Makes sure the code image has at least the required count of cells. New cells are NULL.
+ * @param code The code image
+ * @param length The required count of cells
+ * @return Whether succeeded. FALSE if the image couldn't grow that much.
+ */
+bool reserve_code_image(code_image *code, long length);
+
+/**
+ * Makes sure the data image has at least the required count of cells.
+ * @param data The data image
+ * @param length The required count of cells
+ * @return Whether succeeded. FALSE if the image couldn't grow that much.
+ */
+bool reserve_data_image(data_image *data, long length);
+
+/**
+ * Deallocates both images
+ * @param code The code image
+ * @param data The data image
+ */
+void free_images(code_image *code, data_image *data);
+
+#endif
@@ -0,0 +1,45 @@
+/* Implements the list of line IR records */
+#include <stdio.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include "ir.h"
+#include "names.h"
+
+void init_ir(ir_list *ir, arena *mem) {
+	ir->lines = NULL;
+	ir->count = ir->capacity = 0;
+	ir->mem = mem;
+}
+
+line_ir *add_ir_line(ir_list *ir, line_kind kind, long line_number, long label) {
+	line_ir *new_line;
+	/* Double the capacity when full, so appending is amortized O(1) */
+	if (ir->count == ir->capacity) {
+		long new_capacity = ir->capacity ? ir->capacity * 2 : CODE_ARR_IMG_LENGTH;
+		line_ir *lines = realloc(ir->lines, new_capacity * sizeof(line_ir));
+		if (lines == NULL) {
+			/* The lines so far are still the list's, and deallocated with it */
+			if (ir->mem->on_failure != NULL) longjmp(*ir->mem->on_failure, 1);
+			printf("Error: Fatal: Memory allocation failed.");
+			exit(1);
+		}
+		ir->lines = lines;
+		ir->capacity = new_capacity;
+	}
+	new_line = &ir->lines[ir->count++];
+	new_line->kind = kind;
+	new_line->line_number = line_number;
+	new_line->label = label;
+	new_line->address = new_line->length = 0;
+	new_line->opcode = NONE_OP;
+	new_line->funct = NONE_FUNCT;
+	new_line->operand_count = 0;
+	new_line->operands[0].addressing = new_line->operands[1].addressing = NONE_ADDR;
+	new_line->operands[0].value = new_line->operands[1].value = 0;
+	return new_line;
+}
+
+void free_ir(ir_list *ir) {
+	free(ir->lines);
+	init_ir(ir, ir->mem);
+}
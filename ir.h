@@ -0,0 +1,79 @@
+/* Intermediate representation of the source lines - produced by the first pass, used by the later stages */
+#ifndef _IR_H
+#define _IR_H
+#include "globals.h"
+#include "arena.h"
+
+/** The kind of a source line */
+typedef enum line_kind {
+	/** An instruction (mov, add, etc.) */
+	CODE_LINE,
+	/** .data or .string */
+	DATA_LINE,
+	/** .extern */
+	EXTERN_LINE,
+	/** .entry */
+	ENTRY_LINE
+} line_kind;
+
+/** A single operand, already classified */
+typedef struct operand {
+	addressing_type addressing;
+	/** The immediate value, the register number, or the symbol's name id (direct/relative) */
+	long value;
+} operand;
+
+/** A single source line */
+typedef struct line_ir {
+	line_kind kind;
+	/** Line number in file */
+	long line_number;
+	/** The name id of the label the line defines, NONE_NAME if none */
+	long label;
+	/** Address of the line's first word - IC for code lines, DC for data lines */
+	long address;
+	/** Count of words the line takes */
+	long length;
+	/** Code lines: the opcode & funct */
+	opcode opcode;
+	funct funct;
+	/** The operands. For .extern/.entry, the declared symbol (direct addressing) */
+	int operand_count;
+	operand operands[2];
+} line_ir;
+
+/** The lines of a single file, by their order in the source */
+typedef struct ir_list {
+	line_ir *lines;
+	long count;
+	/** Count of cells allocated */
+	long capacity;
+	/** The file's arena - failing to grow the list jumps to it's on_failure, as failing to grow the arena does */
+	arena *mem;
+} ir_list;
+
+/**
+ * Initializes an empty list
+ * @param ir The list to initialize
+ * @param mem The arena of the file
+ */
+void init_ir(ir_list *ir, arena *mem);
+
+/**
+ * Appends a new line to the list, growing it as needed.
+ * Jumps to the arena's on_failure if failed to grow, or exits the program if not set.
+ * @param ir The list
+ * @param kind The kind of the line
+ * @param line_number The source line number
+ * @param label The name id of the label the line defines, NONE_NAME if none
+ * @return A pointer to the new line, valid until the next line is added
+ */
+line_ir *add_ir_line(ir_list *ir, line_kind kind, long line_number, long label);
+
+/**
+ * Deallocates the list
+ * @param ir The list
+ */
+void free_ir(ir_list *ir);
+
+#endif
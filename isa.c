@@ -0,0 +1,8 @@
+/* The instruction set table, generated from ISA_TABLE */
+#include "isa.h"
+
+#define ISA_ENTRY(upper, name, op, fun, count, source, destination) {name, op, fun, count, source, destination},
+isa_operation isa_table[ISA_COUNT] = {
+		ISA_TABLE(ISA_ENTRY)
+};
+#undef ISA_ENTRY
@@ -0,0 +1,63 @@
+/* Describes the instruction set: each operation's opcode, funct, operands and their allowed addressing modes */
+#ifndef _ISA_H
+#define _ISA_H
+#include "globals.h"
+
+/** A mask of a single addressing type, for the allowed modes of an operand */
+#define MODE(addressing) (1u << (addressing))
+#define IMMEDIATE_MODE MODE(IMMEDIATE_ADDR)
+#define DIRECT_MODE MODE(DIRECT_ADDR)
+#define RELATIVE_MODE MODE(RELATIVE_ADDR)
+#define REGISTER_MODE MODE(REGISTER_ADDR)
+
+/** Whether an addressing is allowed by a mask of modes. An empty mask allows no operand at all (NONE_ADDR). */
+#define IS_MODE_ALLOWED(modes, addressing) \
+        ((addressing) == NONE_ADDR ? (modes) == 0 : ((modes) & MODE(addressing)) != 0)
+
+/**
+ * The instruction set, as X(NAME, name, opcode, funct, operand count, source modes, destination modes).
+ * This is the only definition of the operations - a new one takes it's row here, and it's behaviour in the simulator.
+ * An operation with a single operand has only a destination. Each operand takes a single extra word.
+ */
+#define ISA_TABLE(X) \
+        X(MOV,  "mov",  0,  NONE_FUNCT, 2, IMMEDIATE_MODE | DIRECT_MODE | REGISTER_MODE, DIRECT_MODE | REGISTER_MODE) \
+        X(CMP,  "cmp",  1,  NONE_FUNCT, 2, IMMEDIATE_MODE | DIRECT_MODE | REGISTER_MODE, \
+                                          IMMEDIATE_MODE | DIRECT_MODE | REGISTER_MODE) \
+        X(ADD,  "add",  2,  10,         2, IMMEDIATE_MODE | DIRECT_MODE | REGISTER_MODE, DIRECT_MODE | REGISTER_MODE) \
+        X(SUB,  "sub",  2,  11,         2, IMMEDIATE_MODE | DIRECT_MODE | REGISTER_MODE, DIRECT_MODE | REGISTER_MODE) \
+        X(LEA,  "lea",  4,  NONE_FUNCT, 2, DIRECT_MODE, DIRECT_MODE | REGISTER_MODE) \
+        X(CLR,  "clr",  5,  10,         1, 0, DIRECT_MODE | REGISTER_MODE) \
+        X(NOT,  "not",  5,  11,         1, 0, DIRECT_MODE | REGISTER_MODE) \
+        X(INC,  "inc",  5,  12,         1, 0, DIRECT_MODE | REGISTER_MODE) \
+        X(DEC,  "dec",  5,  13,         1, 0, DIRECT_MODE | REGISTER_MODE) \
+        X(JMP,  "jmp",  9,  10,         1, 0, DIRECT_MODE | RELATIVE_MODE) \
+        X(BNE,  "bne",  9,  11,         1, 0, DIRECT_MODE | RELATIVE_MODE) \
+        X(JSR,  "jsr",  9,  12,         1, 0, DIRECT_MODE | RELATIVE_MODE) \
+        X(RED,  "red",  12, NONE_FUNCT, 1, 0, DIRECT_MODE | REGISTER_MODE) \
+        X(PRN,  "prn",  13, NONE_FUNCT, 1, 0, IMMEDIATE_MODE | DIRECT_MODE | REGISTER_MODE) \
+        X(RTS,  "rts",  14, NONE_FUNCT, 0, 0, 0) \
+        X(STOP, "stop", 15, NONE_FUNCT, 0, 0, 0)
+
+/** A single operation of the instruction set */
+typedef struct isa_operation {
+	char *name;
+	opcode opcode;
+	funct funct;
+	int operand_count;
+	/** Masks of the allowed addressing modes of the source & destination operands */
+	unsigned int source_modes;
+	unsigned int destination_modes;
+} isa_operation;
+
+/** Indexes of the operations in isa_table, e.g. MOV_ISA */
+#define ISA_INDEX(upper, name, op, fun, count, source, destination) upper##_ISA,
+typedef enum isa_index {
+	ISA_TABLE(ISA_INDEX)
+	ISA_COUNT
+} isa_index;
+#undef ISA_INDEX
+
+/** The operations, by isa_index */
+extern isa_operation isa_table[ISA_COUNT];
+
+#endif
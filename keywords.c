@@ -0,0 +1,105 @@
+/* Implements the keyword classifier: the keywords are chained by their first chars, from the tables of the operations and
+ * the directives - so a word is compared only with the few keywords that start like it */
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include "keywords.h"
+
+/** A single directive name */
+struct directive_entry {
+	char *name;
+	instruction value;
+};
+
+/** The directives. Operations are in isa_table, and registers are recognized without a table */
+static struct directive_entry directives_table[] = {
+		{"data",   DATA_INST},
+		{"string", STRING_INST},
+		{"entry",  ENTRY_INST},
+		{"extern", EXTERN_INST}
+};
+
+/** Indexes of the keywords: the operations (same as isa_index), then the directives (from DATA_KW) */
+#define KEYWORD_INDEX(upper, name, op, fun, count, source, destination) upper##_KW,
+enum keyword_index {
+	ISA_TABLE(KEYWORD_INDEX)
+	DATA_KW, STRING_KW, ENTRY_KW, EXTERN_KW, NONE_KW = -1
+};
+#undef KEYWORD_INDEX
+
+/** Count of the keywords */
+#define KEYWORD_COUNT (EXTERN_KW + 1)
+
+/** The first keyword of each first char, NONE_KW if there's none */
+static signed char first_keywords[UCHAR_MAX + 1];
+/** The next keyword with the same first char of each keyword, NONE_KW after the last */
+static signed char next_keywords[KEYWORD_COUNT];
+/** The length of each keyword's name */
+static unsigned char keyword_lengths[KEYWORD_COUNT];
+/** Whether the chains above are built */
+static bool are_chains_built = FALSE;
+
+/**
+ * Returns the name of a keyword
+ * @param index The index of the keyword
+ * @return The operation's name or the directive's name
+ */
+static char *keyword_name(int index) {
+	return index < DATA_KW ? isa_table[index].name : directives_table[index - DATA_KW].name;
+}
+
+/**
+ * Chains the keywords by their first chars, from isa_table and directives_table.
+ * Built before main where it's supported, so the workers of the first pass only read the chains
+ */
+#ifdef __GNUC__
+__attribute__((constructor))
+#endif
+static void build_chains(void) {
+	int i;
+	for (i = 0; i <= UCHAR_MAX; i++) first_keywords[i] = NONE_KW;
+	/* Backwards, so each chain is in the order of the tables */
+	for (i = KEYWORD_COUNT - 1; i >= 0; i--) {
+		unsigned char first = (unsigned char) keyword_name(i)[0];
+		keyword_lengths[i] = (unsigned char) strlen(keyword_name(i));
+		next_keywords[i] = first_keywords[first];
+		first_keywords[first] = (signed char) i;
+	}
+	are_chains_built = TRUE;
+}
+
+/**
+ * Returns the keyword the word is, comparing it only with the keywords that have it's first char and length
+ * @param name The word
+ * @param length The length of the word
+ * @return The index of the keyword, NONE_KW if there's none
+ */
+static int find_keyword(char *name, size_t length) {
+	int index;
+	if (length == 0) return NONE_KW;
+	if (!are_chains_built) build_chains();
+	for (index = first_keywords[(unsigned char) name[0]]; index != NONE_KW; index = next_keywords[index]) {
+		if (keyword_lengths[index] == length && memcmp(keyword_name(index), name, length) == 0) return index;
+	}
+	return NONE_KW;
+}
+
+keyword classify_keyword(char *name, size_t length) {
+	keyword result = {NONE_KEYWORD, NULL, NONE_REG, NONE_INST};
+	int index;
+	/* r0-r7 */
+	if (length == 2 && name[0] == 'r' && name[1] >= '0' && name[1] <= '7') {
+		result.kind = REGISTER_KEYWORD;
+		result.reg = name[1] - '0';
+		return result;
+	}
+	if ((index = find_keyword(name, length)) == NONE_KW) return result;
+	if (index < DATA_KW) {
+		result.kind = OPERATION_KEYWORD;
+		result.operation = &isa_table[index];
+	} else {
+		result.kind = DIRECTIVE_KEYWORD;
+		result.directive = directives_table[index - DATA_KW].value;
+	}
+	return result;
+}
@@ -0,0 +1,38 @@
+/* Recognizes the reserved words of the language - operations, registers and directives - in a single probe */
+#ifndef _KEYWORDS_H
+#define _KEYWORDS_H
+#include "globals.h"
+#include "isa.h"
+
+/** The kind of a reserved word */
+typedef enum keyword_kind {
+	/** Not a reserved word */
+	NONE_KEYWORD,
+	/** An operation (mov, add, etc.) */
+	OPERATION_KEYWORD,
+	/** A register (r0-r7) */
+	REGISTER_KEYWORD,
+	/** A directive name, without the '.' (data, string, entry, extern) */
+	DIRECTIVE_KEYWORD
+} keyword_kind;
+
+/** What a reserved word stands for. Only the fields of it's kind are set, the rest are NONE (or NULL) */
+typedef struct keyword {
+	keyword_kind kind;
+	/** Operations: the operation's description */
+	isa_operation *operation;
+	/** Registers: the register number */
+	reg reg;
+	/** Directives: the instruction */
+	instruction directive;
+} keyword;
+
+/**
+ * Classifies a word - by it's first char, and comparisons with the keywords of it's first char and length
+ * @param name The word
+ * @param length The length of the word
+ * @return What the word stands for, NONE_KEYWORD kind if it isn't a reserved word
+ */
+keyword classify_keyword(char *name, size_t length);
+
+#endif
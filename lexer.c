@@ -0,0 +1,364 @@
+/* Implements the lexer: each char is classified, and the (state, class) cell of the transition table tells what to do
+ * with it and which state comes next. Words are classified once, when they end - so each state knows what follows.
+ * The chars a state stays on are never looked at - the lexer jumps over them by the delimiter masks of the line */
+#include <string.h>
+#include <limits.h>
+#include "lexer.h"
+#include "code.h"
+#include "scan.h"
+#include "utils.h"
+
+/** The classes of the chars, as far as the lexer cares */
+typedef enum lex_class {
+	/** Spaces and tabs */
+	WHITE_CHAR,
+	COMMA_CHAR,
+	/** ':' - the first one of the line ends a label's definition, and is just a char after it */
+	COLON_CHAR,
+	QUOTE_CHAR,
+	/** ';' - a comment, where a line starts */
+	SEMICOLON_CHAR,
+	/** '.' - a directive, where a statement starts */
+	DOT_CHAR,
+	/** The terminator, a line break or an EOF char */
+	END_CHAR,
+	/** Anything else */
+	OTHER_CHAR,
+	LEX_CLASS_COUNT
+} lex_class;
+
+/** The states of the lexer */
+typedef enum lex_state {
+	/** Before the first token */
+	START_STATE,
+	/** After a label's definition, before the statement */
+	STATEMENT_STATE,
+	/** In the name of a directive */
+	DIRECTIVE_STATE,
+	/** In the name of an operation */
+	MNEMONIC_STATE,
+	/** Between the operands of a code line */
+	OPERANDS_STATE,
+	/** In an operand */
+	OPERAND_STATE,
+	/** Between the integers of .data */
+	DATA_STATE,
+	/** In an integer */
+	NUMBER_STATE,
+	/** Before the text of .string */
+	STRING_ARG_STATE,
+	/** In the text of .string */
+	STRING_STATE,
+	/** Before the symbol of .extern/.entry */
+	SYMBOL_ARG_STATE,
+	/** In the symbol */
+	SYMBOL_STATE,
+	/** After anything the parsers read - the rest is dropped */
+	REST_STATE,
+	/** In a comment */
+	COMMENT_STATE,
+	/** Past the end of the line */
+	DONE_STATE,
+	/** Not a real state: the state that the word which just ended leads to */
+	FOLLOW_STATE
+} lex_state;
+
+/** What to do with a char */
+typedef enum lex_action {
+	/** Nothing - the char is white, or in the middle of a token */
+	SKIP_ACTION,
+	/** The char starts a token */
+	BEGIN_ACTION,
+	/** The char starts a string - which is it's opening quote */
+	BEGIN_STRING_ACTION,
+	/** The char is a quote in a string */
+	QUOTE_ACTION,
+	/** The char ends the current token */
+	FINISH_ACTION,
+	/** The char is a comma */
+	COMMA_ACTION,
+	/** The char is a comma that ends the current token */
+	FINISH_COMMA_ACTION,
+	/** The char is the first colon of the line - everything before it is a label's definition */
+	LABEL_ACTION
+} lex_action;
+
+/** A cell of the transition table */
+typedef struct lex_transition {
+	lex_action action;
+	lex_state next;
+} lex_transition;
+
+/* Short names, to keep the table readable */
+#define SKIP(next) {SKIP_ACTION, next##_STATE}
+#define BEGIN(next) {BEGIN_ACTION, next##_STATE}
+#define FINISH(next) {FINISH_ACTION, next##_STATE}
+#define LABEL {LABEL_ACTION, STATEMENT_STATE}
+
+/** The transitions, by the state and the class of the char. The order of the classes is:
+ *  white,      comma,      colon,      quote,      semicolon,  dot,        end,           other */
+static const lex_transition transitions[DONE_STATE][LEX_CLASS_COUNT] = {
+		/* START_STATE */
+		{SKIP(START), BEGIN(MNEMONIC), LABEL, BEGIN(MNEMONIC), BEGIN(COMMENT), BEGIN(DIRECTIVE), SKIP(DONE),
+		 BEGIN(MNEMONIC)},
+		/* STATEMENT_STATE - no comment after a label */
+		{SKIP(STATEMENT), BEGIN(MNEMONIC), BEGIN(MNEMONIC), BEGIN(MNEMONIC), BEGIN(MNEMONIC), BEGIN(DIRECTIVE),
+		 SKIP(DONE), BEGIN(MNEMONIC)},
+		/* DIRECTIVE_STATE */
+		{FINISH(FOLLOW), SKIP(DIRECTIVE), LABEL, SKIP(DIRECTIVE), SKIP(DIRECTIVE), SKIP(DIRECTIVE), FINISH(DONE),
+		 SKIP(DIRECTIVE)},
+		/* MNEMONIC_STATE - a comma doesn't end the name */
+		{FINISH(FOLLOW), SKIP(MNEMONIC), LABEL, SKIP(MNEMONIC), SKIP(MNEMONIC), SKIP(MNEMONIC), FINISH(DONE),
+		 SKIP(MNEMONIC)},
+		/* OPERANDS_STATE */
+		{SKIP(OPERANDS), {COMMA_ACTION, OPERANDS_STATE}, LABEL, BEGIN(OPERAND), BEGIN(OPERAND), BEGIN(OPERAND),
+		 SKIP(DONE), BEGIN(OPERAND)},
+		/* OPERAND_STATE */
+		{FINISH(OPERANDS), {FINISH_COMMA_ACTION, OPERANDS_STATE}, LABEL, SKIP(OPERAND), SKIP(OPERAND), SKIP(OPERAND),
+		 FINISH(DONE), SKIP(OPERAND)},
+		/* DATA_STATE */
+		{SKIP(DATA), {COMMA_ACTION, DATA_STATE}, LABEL, BEGIN(NUMBER), BEGIN(NUMBER), BEGIN(NUMBER), SKIP(DONE),
+		 BEGIN(NUMBER)},
+		/* NUMBER_STATE */
+		{FINISH(DATA), {FINISH_COMMA_ACTION, DATA_STATE}, LABEL, SKIP(NUMBER), SKIP(NUMBER), SKIP(NUMBER),
+		 FINISH(DONE), SKIP(NUMBER)},
+		/* STRING_ARG_STATE - anything but a quote means there's no string */
+		{SKIP(STRING_ARG), SKIP(REST), LABEL, {BEGIN_STRING_ACTION, STRING_STATE}, SKIP(REST), SKIP(REST), SKIP(DONE),
+		 SKIP(REST)},
+		/* STRING_STATE - up to the end of the line */
+		{SKIP(STRING), SKIP(STRING), LABEL, {QUOTE_ACTION, STRING_STATE}, SKIP(STRING), SKIP(STRING), FINISH(DONE),
+		 SKIP(STRING)},
+		/* SYMBOL_ARG_STATE */
+		{SKIP(SYMBOL_ARG), BEGIN(SYMBOL), LABEL, BEGIN(SYMBOL), BEGIN(SYMBOL), BEGIN(SYMBOL), SKIP(DONE),
+		 BEGIN(SYMBOL)},
+		/* SYMBOL_STATE */
+		{FINISH(REST), SKIP(SYMBOL), LABEL, SKIP(SYMBOL), SKIP(SYMBOL), SKIP(SYMBOL), FINISH(DONE), SKIP(SYMBOL)},
+		/* REST_STATE - only looking for the first colon */
+		{SKIP(REST), SKIP(REST), LABEL, SKIP(REST), SKIP(REST), SKIP(REST), SKIP(DONE), SKIP(REST)},
+		/* COMMENT_STATE */
+		{SKIP(COMMENT), SKIP(COMMENT), SKIP(COMMENT), SKIP(COMMENT), SKIP(COMMENT), SKIP(COMMENT), FINISH(DONE),
+		 SKIP(COMMENT)}
+};
+
+#undef SKIP
+#undef BEGIN
+#undef FINISH
+#undef LABEL
+
+/** The lexer's class of each class of the masks (the masks have no class for '.', it's as any other char for them) */
+static const lex_class mask_classes[CLASS_COUNT] = {
+		WHITE_CHAR, COMMA_CHAR, COLON_CHAR, QUOTE_CHAR, SEMICOLON_CHAR, END_CHAR, END_CHAR
+};
+
+/** Whether a state stays as is on a class of chars, doing nothing */
+#define STAYS_ON(state, class) \
+	(transitions[(state)][(class)].action == SKIP_ACTION && transitions[(state)][(class)].next == (state))
+
+/**
+ * Returns the classes of the masks that a state stops on - the rest of the chars are skipped
+ * @param state The state. It must stay on OTHER_CHAR, and so on '.' as well
+ * @param is_labeled Whether the label's colon was read already - the next ones are as any other char
+ * @return The classes, as a mask of CLASS_MASK(class) values
+ */
+static unsigned int stop_classes(lex_state state, bool is_labeled) {
+	int class;
+	unsigned int classes = 0;
+	for (class = 0; class < CLASS_COUNT; class++) {
+		if (class == COLON_CLASS && is_labeled) continue;
+		if (!STAYS_ON(state, mask_classes[class])) classes |= CLASS_MASK(class);
+	}
+	return classes;
+}
+
+/**
+ * Returns the class of a char
+ * @param c The char
+ * @return The class
+ */
+static lex_class class_of(char c) {
+	switch (c) {
+		case ' ':
+		case '\t':
+			return WHITE_CHAR;
+		case ',':
+			return COMMA_CHAR;
+		case ':':
+			return COLON_CHAR;
+		case '"':
+			return QUOTE_CHAR;
+		case ';':
+			return SEMICOLON_CHAR;
+		case '.':
+			return DOT_CHAR;
+		case '\0':
+		case '\n':
+		case (char) EOF:
+			return END_CHAR;
+		default:
+			return OTHER_CHAR;
+	}
+}
+
+/**
+ * Adds a token to the stream
+ * @param tokens The stream
+ * @param kind The kind of the token
+ * @param column The column of the token's first char
+ * @param length The count of the token's chars
+ * @return The added token, or NULL if the stream is full
+ */
+static lex_token *add_token(token_stream *tokens, token_kind kind, int column, int length) {
+	lex_token *token;
+	if (tokens->count == MAX_LINE_TOKENS) return NULL;
+	token = &tokens->tokens[tokens->count++];
+	token->kind = kind;
+	token->column = column;
+	token->length = length;
+	token->keyword.kind = NONE_KEYWORD;
+	token->last_quote = column;
+	token->value = 0;
+	return token;
+}
+
+/**
+ * Parses an integer - an optional sign, and at least a digit - as strtol does, clamping what's out of range
+ * @param text The integer's text
+ * @param length The length of the text
+ * @param value Where to return the value
+ * @return Whether it's an integer, as is_int tells
+ */
+static bool parse_int(char *text, int length, long *value) {
+	int i = 0, digit;
+	bool is_negative = length > 0 && text[0] == '-';
+	unsigned long magnitude = 0, limit = is_negative ? (unsigned long) LONG_MAX + 1 : (unsigned long) LONG_MAX;
+	if (length > 0 && (text[0] == '-' || text[0] == '+')) i++;
+	if (i == length) return FALSE;
+	for (; i < length; i++) {
+		if (text[i] < '0' || text[i] > '9') return FALSE;
+		digit = text[i] - '0';
+		magnitude = magnitude <= (limit - digit) / 10 ? magnitude * 10 + digit : limit;
+	}
+	if (!is_negative) *value = (long) magnitude;
+	else *value = magnitude == limit ? LONG_MIN : -(long) magnitude;
+	return TRUE;
+}
+
+/**
+ * Adds the token which just ended, classified by the state it was read in
+ * @param content The line
+ * @param tokens The stream
+ * @param state The state of the token
+ * @param start The column of the token's first char
+ * @param end The column after the token's last char
+ * @param last_quote The column of the last quote that was read
+ * @return The state that follows the token
+ */
+static lex_state finish_token(char *content, token_stream *tokens, lex_state state, int start, int end,
+                              int last_quote) {
+	lex_token *token;
+	char *text = content + start;
+	int length = end - start;
+	switch (state) {
+		case DIRECTIVE_STATE:
+			if ((token = add_token(tokens, DIRECTIVE_TOKEN, start, length)) == NULL) return DONE_STATE;
+			token->keyword = classify_keyword(text + 1, length - 1);
+			if (token->keyword.kind != DIRECTIVE_KEYWORD) return REST_STATE;
+			if (token->keyword.directive == DATA_INST) return DATA_STATE;
+			return token->keyword.directive == STRING_INST ? STRING_ARG_STATE : SYMBOL_ARG_STATE;
+		case MNEMONIC_STATE:
+			if ((token = add_token(tokens, MNEMONIC_TOKEN, start, length)) == NULL) return DONE_STATE;
+			token->keyword = classify_keyword(text, length);
+			return token->keyword.kind == OPERATION_KEYWORD ? OPERANDS_STATE : REST_STATE;
+		case OPERAND_STATE:
+			switch (get_addressing_type(text, length)) {
+				case REGISTER_ADDR:
+					add_token(tokens, REGISTER_TOKEN, start, length);
+					break;
+				case IMMEDIATE_ADDR:
+					if ((token = add_token(tokens, IMMEDIATE_TOKEN, start, length)) != NULL) {
+						parse_int(text + 1, length - 1, &token->value);
+					}
+					break;
+				case RELATIVE_ADDR:
+					add_token(tokens, RELATIVE_REF_TOKEN, start, length);
+					break;
+				case DIRECT_ADDR:
+					add_token(tokens, LABEL_REF_TOKEN, start, length);
+					break;
+				default:
+					add_token(tokens, WORD_TOKEN, start, length);
+			}
+			return OPERANDS_STATE;
+		case NUMBER_STATE:
+			if ((token = add_token(tokens, WORD_TOKEN, start, length)) != NULL && parse_int(text, length, &token->value)) {
+				token->kind = NUMBER_TOKEN;
+			}
+			return DATA_STATE;
+		case SYMBOL_STATE:
+			add_token(tokens, is_valid_label_name(text, length) ? LABEL_REF_TOKEN : WORD_TOKEN, start, length);
+			return REST_STATE;
+		case STRING_STATE:
+			if ((token = add_token(tokens, STRING_TOKEN, start, length)) != NULL) token->last_quote = last_quote;
+			return DONE_STATE;
+		default: /* COMMENT_STATE */
+			add_token(tokens, COMMENT_TOKEN, start, length);
+			return DONE_STATE;
+	}
+}
+
+void lex_line(char *content, long length, token_stream *tokens) {
+	int i, start = 0, first = 0, last_quote = 0;
+	bool is_labeled = FALSE;
+	lex_class class;
+	lex_state state = START_STATE, following = DONE_STATE;
+	lex_transition transition;
+	line_masks masks;
+	/* The classes each state stops on, by the time it's first entered (0 - not yet) */
+	unsigned int stops[DONE_STATE] = {0};
+	scan_line(content, length, &masks);
+	tokens->count = 0;
+	for (i = 0; state != DONE_STATE;) {
+		class = class_of(content[i]);
+		if (class == COLON_CHAR && is_labeled) class = OTHER_CHAR;
+		if (state == START_STATE) first = i; /* Where the label's definition starts, if there's one */
+		transition = transitions[state][class];
+		switch (transition.action) {
+			case SKIP_ACTION:
+				break;
+			case BEGIN_STRING_ACTION:
+				last_quote = i;
+				/* fall through */
+			case BEGIN_ACTION:
+				start = i;
+				break;
+			case QUOTE_ACTION:
+				last_quote = i;
+				break;
+			case FINISH_ACTION:
+				following = finish_token(content, tokens, state, start, i, last_quote);
+				break;
+			case FINISH_COMMA_ACTION:
+				finish_token(content, tokens, state, start, i, last_quote);
+				/* fall through */
+			case COMMA_ACTION:
+				add_token(tokens, COMMA_TOKEN, i, 1);
+				break;
+			case LABEL_ACTION: /* Whatever was read is the label - the statement starts after the colon */
+				tokens->count = 0;
+				add_token(tokens, LABEL_DEF_TOKEN, first, i - first);
+				is_labeled = TRUE;
+				memset(stops, 0, sizeof(stops)); /* Colons don't stop anything anymore */
+				break;
+		}
+		if (transition.next != state) {
+			state = transition.next == FOLLOW_STATE ? following : transition.next;
+			if (state == DONE_STATE) break;
+			if (STAYS_ON(state, OTHER_CHAR) && stops[state] == 0) stops[state] = stop_classes(state, is_labeled);
+		}
+
+		/* Jump to the next char the state does something with */
+		if (STAYS_ON(state, OTHER_CHAR)) i = find_class(&masks, stops[state], i + 1);
+		else if (STAYS_ON(state, WHITE_CHAR)) i = skip_class(&masks, CLASS_MASK(WHITE_CLASS), i + 1);
+		else i++;
+	}
+}
@@ -0,0 +1,71 @@
+/* Splits a source line into it's tokens, in a single pass over it's delimiters - by a table-driven state machine.
+ * The parsers of the first pass go over the tokens, instead of scanning the line by themselves */
+#ifndef _LEXER_H
+#define _LEXER_H
+#include "globals.h"
+#include "keywords.h"
+
+/** Maximum count of tokens of a line - a token takes at least a char (but a label's definition, which takes it's colon) */
+#define MAX_LINE_TOKENS (MAX_LINE_LENGTH + 1)
+
+/** The kind of a token */
+typedef enum token_kind {
+	/** A label's definition - everything before the first colon of the line. It isn't validated */
+	LABEL_DEF_TOKEN,
+	/** A word that starts with '.', where the statement starts */
+	DIRECTIVE_TOKEN,
+	/** Any other word where the statement starts - an operation's name, if it's valid */
+	MNEMONIC_TOKEN,
+	/** An operand of a code line - r0-r7, or *r0-*r7 */
+	REGISTER_TOKEN,
+	/** An operand of a code line - '#' and an integer */
+	IMMEDIATE_TOKEN,
+	/** A label's name - an operand of a code line, or the symbol of .extern/.entry */
+	LABEL_REF_TOKEN,
+	/** An operand of a code line - '%' and a label's name */
+	RELATIVE_REF_TOKEN,
+	/** An integer of .data */
+	NUMBER_TOKEN,
+	/** The text of .string - from it's opening quote to the end of the line */
+	STRING_TOKEN,
+	COMMA_TOKEN,
+	/** A comment line, from it's ';' */
+	COMMENT_TOKEN,
+	/** A word that is none of the above - an invalid operand, integer or symbol */
+	WORD_TOKEN
+} token_kind;
+
+/** A single token - a slice of the source line, which isn't NUL-terminated at it's end */
+typedef struct lex_token {
+	token_kind kind;
+	/** Index of the token's first char in the line */
+	int column;
+	/** Count of the token's chars */
+	int length;
+	/** Directives & mnemonics: what the word stands for (without the '.' of a directive). NONE_KEYWORD if nothing */
+	keyword keyword;
+	/** Strings: the column of the last quote of the line, which is the opening quote if there's no other */
+	int last_quote;
+	/** Numbers & immediates: the value, parsed as strtol does (clamped to the range of long) */
+	long value;
+} lex_token;
+
+/** The tokens of a line */
+typedef struct token_stream {
+	lex_token tokens[MAX_LINE_TOKENS];
+	/** Count of the tokens */
+	int count;
+} token_stream;
+
+/**
+ * Splits a line into it's tokens. Never fails - a line that isn't valid is left for the parsers to report, by the
+ * kinds of it's tokens. Everything after the statement, which it's parser doesn't read (like what comes after the
+ * symbol of .extern), is dropped
+ * @param content The line, NUL-terminated. A line break or an EOF char ends it as well. It must be readable up to the
+ *                end of the scanner's block of it's terminator (see scan_line)
+ * @param length The length of the line - at most MAX_LINE_LENGTH
+ * @param tokens The tokens to fill
+ */
+void lex_line(char *content, long length, token_stream *tokens);
+
+#endif
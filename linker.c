@@ -0,0 +1,187 @@
+/* Links assembled modules (.ob/.ent/.ext, or .obj) into a single absolute image */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "object.h"
+#include "writefiles.h"
+#include "table.h"
+#include "arena.h"
+#include "utils.h"
+
+/** Name of the linked image, when not given (-o) */
+#define DEFAULT_OUTPUT_NAME "a"
+
+/** A module to link, and where it's placed in the image */
+typedef struct linked_module {
+	/** The file name, as given in the arguments */
+	char *argument;
+	object_module module;
+	/** Addresses of the module's code and data in the image */
+	long code_base;
+	long data_base;
+} linked_module;
+
+/**
+ * Returns the address in the image of an address in a module
+ * @param curr The module
+ * @param address The address in the module
+ * @return The address in the image
+ */
+static long relocate(linked_module *curr, long address);
+
+/**
+ * Links the modules into a single image. Each module's code is placed after the previous one's, and all the data
+ * follows all the code. The external references are resolved against the entries of all the modules.
+ * @param modules The modules, already loaded
+ * @param module_count The count of modules
+ * @param image The image to fill
+ * @param mem The arena to allocate the image and the entries table from
+ * @return Whether succeeded
+ */
+static bool link_modules(linked_module *modules, long module_count, object_module *image, arena *mem);
+
+/**
+ * Entry point - links the modules in the arguments, in their order
+ */
+int main(int argc, char *argv[]) {
+	int i;
+	long module_count = 0;
+	char *output_name = DEFAULT_OUTPUT_NAME;
+	bool binary = FALSE, is_success = TRUE;
+	linked_module *modules = calloc_with_check(argc * sizeof(linked_module));
+	object_module image;
+	arena mem;
+
+	/* Collect the modules, the name of the image (-o NAME), and whether to write it's binary object (-b) */
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-b") == 0) {
+			binary = TRUE;
+		} else if (strcmp(argv[i], "-o") == 0) {
+			if (++i == argc) {
+				printf("Error: -o expects the name of the image.\n");
+				free(modules);
+				return 1;
+			}
+			output_name = argv[i];
+		} else {
+			modules[module_count++].argument = argv[i];
+		}
+	}
+	if (module_count == 0) {
+		printf("Usage: %s [-b] [-o name] module...\n", argv[0]);
+		free(modules);
+		return 1;
+	}
+
+	arena_init(&mem);
+	for (i = 0; i < module_count; i++) {
+		if (!read_object(modules[i].argument, &modules[i].module, &mem, stdout)) is_success = FALSE;
+	}
+	is_success = is_success && link_modules(modules, module_count, &image, &mem) &&
+	             write_text_object(&image, output_name, stdout) &&
+	             (!binary || write_binary_object(&image, output_name, stdout));
+	arena_free(&mem);
+	free(modules);
+	return is_success ? 0 : 1;
+}
+
+static long relocate(linked_module *curr, long address) {
+	long offset = address - IC_INIT_VALUE;
+	return offset < curr->module.code_length ? curr->code_base + offset
+	                                          : curr->data_base + offset - curr->module.code_length;
+}
+
+static bool link_modules(linked_module *modules, long module_count, object_module *image, arena *mem) {
+	long i, j, word_count, offset, address;
+	bool is_success = TRUE;
+	linked_module *curr;
+	object_symbol *external;
+	name_table names;
+	table entries;
+	table_entry *entry, **sorted_entries;
+
+	init_names(&names, mem);
+	entries = create_table(&names);
+
+	/* Place the modules - all the code first, then all the data */
+	image->code_length = image->data_length = 0;
+	for (i = 0; i < module_count; i++) image->code_length += modules[i].module.code_length;
+	for (i = 0; i < module_count; i++) {
+		modules[i].code_base = i == 0 ? IC_INIT_VALUE
+		                              : modules[i - 1].code_base + modules[i - 1].module.code_length;
+		modules[i].data_base = IC_INIT_VALUE + image->code_length + image->data_length;
+		image->data_length += modules[i].module.data_length;
+	}
+	word_count = image->code_length + image->data_length;
+	image->words = arena_alloc(mem, (word_count + 1) * sizeof(unsigned int));
+	image->are = arena_alloc(mem, word_count + 1);
+
+	/* Index the entries of all the modules, by their address in the image */
+	for (i = 0, curr = modules; i < module_count; i++, curr++) {
+		for (j = 0; j < curr->module.entry_count; j++) {
+			long name = intern_name(&names, curr->module.entries[j].name);
+			if (find_by_types(entries, name, SYMBOL_MASK(ENTRY_SYMBOL)) != NULL) {
+				printf("Error: Entry symbol %s of %s is already an entry of another module.\n",
+				       curr->module.entries[j].name, curr->argument);
+				is_success = FALSE;
+				continue;
+			}
+			add_table_item(&entries, name, relocate(curr, curr->module.entries[j].address),
+			               ENTRY_SYMBOL);
+		}
+	}
+
+	/* Copy the words, relocating the addresses of the module (R) into the image */
+	for (i = 0, curr = modules; i < module_count; i++, curr++) {
+		word_count = curr->module.code_length + curr->module.data_length;
+		for (j = 0; j < word_count; j++) {
+			address = relocate(curr, IC_INIT_VALUE + j) - IC_INIT_VALUE;
+			image->words[address] = curr->module.words[j];
+			image->are[address] = curr->module.are[j];
+			if (curr->module.are[j] == R_MEM) {
+				image->words[address] = relocate(curr, curr->module.words[j]) & 0xFFF;
+			}
+		}
+		/* Resolve each reference to an external symbol. The word becomes a relocatable address in the image */
+		for (j = 0, external = curr->module.externals; j < curr->module.external_count; j++, external++) {
+			offset = external->address - IC_INIT_VALUE;
+			entry = find_by_types(entries, find_name(&names, external->name), SYMBOL_MASK(ENTRY_SYMBOL));
+			if (offset < 0 || offset >= word_count || curr->module.are[offset] != E_MEM) {
+				printf("Error: External reference to %s at %.4ld of %s is not an external word.\n", external->name,
+				       external->address, curr->argument);
+				is_success = FALSE;
+			} else if (entry == NULL) {
+				printf("Error: Unresolved external symbol %s, referenced at %.4ld of %s.\n", external->name,
+				       external->address, curr->argument);
+				/* Already reported - not as a word without a reference */
+				image->are[relocate(curr, external->address) - IC_INIT_VALUE] = A_MEM;
+				is_success = FALSE;
+			} else {
+				address = relocate(curr, external->address) - IC_INIT_VALUE;
+				image->words[address] = entry->value & 0xFFF;
+				image->are[address] = R_MEM;
+			}
+		}
+		/* Every external word must have been referred by the module's .ext */
+		for (j = 0; j < word_count; j++) {
+			address = relocate(curr, IC_INIT_VALUE + j) - IC_INIT_VALUE;
+			if (image->are[address] == E_MEM) {
+				printf("Error: External word at %.4ld of %s has no external reference.\n", IC_INIT_VALUE + j,
+				       curr->argument);
+				is_success = FALSE;
+			}
+		}
+	}
+
+	/* The image has no external references left, and all the entries of the modules - by address */
+	image->externals = NULL;
+	image->external_count = 0;
+	sorted_entries = filter_table_by_type(entries, ENTRY_SYMBOL);
+	for (image->entry_count = 0; sorted_entries[image->entry_count] != NULL; image->entry_count++);
+	image->entries = arena_alloc(mem, (image->entry_count + 1) * sizeof(object_symbol));
+	for (i = 0; i < image->entry_count; i++) {
+		image->entries[i].name = sorted_entries[i]->key;
+		image->entries[i].address = sorted_entries[i]->value;
+	}
+	return is_success;
+}
@@ -0,0 +1,85 @@
+/* Implements the names table - an array of names, indexed by an open-addressing hash table */
+#include <string.h>
+#include "names.h"
+#include "utils.h"
+
+/** Initial count of names & slots, must be a power of 2 */
+#define INITIAL_NAMES_COUNT 64
+
+/**
+ * Allocates the slots, and puts all the names into them
+ * @param names The names table
+ * @param slot_count The new count of slots
+ */
+static void rebuild_slots(name_table *names, long slot_count) {
+	long id, i;
+	names->slots = arena_alloc(names->mem, slot_count * sizeof(long));
+	names->slot_count = slot_count;
+	for (i = 0; i < slot_count; i++) names->slots[i] = NONE_NAME;
+	for (id = 0; id < names->count; id++) {
+		/* Linear probing */
+		for (i = names->hashes[id] & (slot_count - 1); names->slots[i] != NONE_NAME; i = (i + 1) & (slot_count - 1));
+		names->slots[i] = id;
+	}
+}
+
+void init_names(name_table *names, arena *mem) {
+	names->mem = mem;
+	names->count = 0;
+	names->capacity = INITIAL_NAMES_COUNT;
+	names->names = arena_alloc(mem, INITIAL_NAMES_COUNT * sizeof(char *));
+	names->hashes = arena_alloc(mem, INITIAL_NAMES_COUNT * sizeof(unsigned long));
+	rebuild_slots(names, INITIAL_NAMES_COUNT * 2);
+}
+
+/**
+ * Looks for a name in the slots
+ * @param names The names table
+ * @param name The name
+ * @param hash The hash of the name
+ * @param slot Where to return the slot of the name - or the empty slot where it belongs, if it's not in the table
+ * @return The id of the name, or NONE_NAME if it's not in the table
+ */
+static long find_slot(name_table *names, char *name, unsigned long hash, long *slot) {
+	long i, id;
+	for (i = hash & (names->slot_count - 1); (id = names->slots[i]) != NONE_NAME; i = (i + 1) & (names->slot_count - 1)) {
+		if (names->hashes[id] == hash && strcmp(names->names[id], name) == 0) break;
+	}
+	*slot = i;
+	return id;
+}
+
+long find_name(name_table *names, char *name) {
+	long slot;
+	return find_slot(names, name, hash_string(name), &slot);
+}
+
+long intern_name(name_table *names, char *name) {
+	long i, id;
+	unsigned long hash = hash_string(name);
+	/* Look for the name first */
+	if ((id = find_slot(names, name, hash, &i)) != NONE_NAME) return id;
+	/* New name - make room for it. The slots are kept at most half full. */
+	if (names->count == names->capacity) {
+		char **new_names = arena_alloc(names->mem, names->capacity * 2 * sizeof(char *));
+		unsigned long *new_hashes = arena_alloc(names->mem, names->capacity * 2 * sizeof(unsigned long));
+		memcpy(new_names, names->names, names->count * sizeof(char *));
+		memcpy(new_hashes, names->hashes, names->count * sizeof(unsigned long));
+		names->names = new_names;
+		names->hashes = new_hashes;
+		names->capacity *= 2;
+	}
+	id = names->count++;
+	names->names[id] = arena_strdup(names->mem, name);
+	names->hashes[id] = hash;
+	if (names->count * 2 > names->slot_count) {
+		rebuild_slots(names, names->slot_count * 2);
+	} else {
+		names->slots[i] = id;
+	}
+	return id;
+}
+
+char *name_by_id(name_table *names, long id) {
+	return names->names[id];
+}
@@ -0,0 +1,56 @@
+/* Implements a table of symbol names - each distinct name gets a single id */
+#ifndef _NAMES_H
+#define _NAMES_H
+#include "arena.h"
+
+/** Id of no name */
+#define NONE_NAME (-1)
+
+/** The names table */
+typedef struct name_table {
+	/** The names, indexed by id */
+	char **names;
+	/** Hash of each name, indexed by id */
+	unsigned long *hashes;
+	long count;
+	/** Count of cells allocated for names & hashes */
+	long capacity;
+	/** Open-addressing hash slots, holding ids (NONE_NAME for empty). slot_count is a power of 2. */
+	long *slots;
+	long slot_count;
+	/** The arena which the names are allocated from */
+	arena *mem;
+} name_table;
+
+/**
+ * Initializes an empty names table. It's released with the arena.
+ * @param names The table to initialize
+ * @param mem The arena to allocate the names from
+ */
+void init_names(name_table *names, arena *mem);
+
+/**
+ * Returns the id of a name, adding it to the table if it's new
+ * @param names The names table
+ * @param name The name
+ * @return The id of the name
+ */
+long intern_name(name_table *names, char *name);
+
+/**
+ * Returns the id of a name, without adding it to the table
+ * @param names The names table
+ * @param name The name
+ * @return The id of the name, or NONE_NAME if it's not in the table
+ */
+long find_name(name_table *names, char *name);
+
+/**
+ * Returns the name by it's id
+ * @param names The names table
+ * @param id The id of the name
+ * @return The name
+ */
+char *name_by_id(name_table *names, long id);
+
+#endif
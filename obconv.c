@@ -0,0 +1,61 @@
+/* Converts object files between the text format (.ob, .ent, .ext) and the binary format (.obj) */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "object.h"
+#include "writefiles.h"
+#include "arena.h"
+#include "utils.h"
+
+/**
+ * Converts a single object file to the other format, next to it
+ * @param argument The file name - a .ob file to convert to binary, or an .obj file to convert to text
+ * @param mem The arena to allocate the module from
+ * @return Whether succeeded
+ */
+static bool convert_file(char *argument, arena *mem);
+
+/**
+ * Entry point - converts each of the files in the arguments
+ */
+int main(int argc, char *argv[]) {
+	int i;
+	bool is_success = TRUE;
+	arena mem;
+	if (argc < 2) {
+		printf("Usage: %s file.ob|file.obj...\n", argv[0]);
+		return 1;
+	}
+	arena_init(&mem);
+	for (i = 1; i < argc; i++) {
+		if (!convert_file(argv[i], &mem)) is_success = FALSE;
+		arena_reset(&mem);
+	}
+	arena_free(&mem);
+	return is_success ? 0 : 1;
+}
+
+static bool convert_file(char *argument, arena *mem) {
+	bool is_success;
+	object_module module;
+	long length = strlen(argument);
+	char *filename;
+	bool to_binary = length > 3 && strcmp(argument + length - 3, ".ob") == 0;
+	if (!to_binary && (length <= 4 || strcmp(argument + length - 4, ".obj") != 0)) {
+		printf("Error: \"%s\" is not a .ob or a .obj file. skipping it.\n", argument);
+		return FALSE;
+	}
+	/* Drop the extension - the other files are next to it */
+	filename = calloc_with_check(length + 1);
+	strncpy(filename, argument, length - (to_binary ? 3 : 4));
+
+	if (to_binary) {
+		is_success = read_text_object(filename, &module, mem, stdout) &&
+		             write_binary_object(&module, filename, stdout);
+	} else {
+		is_success = read_binary_object(filename, &module, mem, stdout) &&
+		             write_text_object(&module, filename, stdout);
+	}
+	free(filename);
+	return is_success;
+}
@@ -0,0 +1,336 @@
+/* Implements the object module of an assembled file: it's binary format, and reading it's text and binary files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "object.h"
+#include "source.h"
+#include "utils.h"
+
+/** Offsets of the header fields */
+#define MAGIC_OFFSET 0
+#define VERSION_OFFSET 4
+#define CODE_LENGTH_OFFSET 8
+#define DATA_LENGTH_OFFSET 12
+#define ENTRY_COUNT_OFFSET 16
+#define EXTERNAL_COUNT_OFFSET 20
+#define STRINGS_SIZE_OFFSET 24
+#define LOAD_ADDRESS_OFFSET 28
+
+/** Size of a single symbol in the binary format */
+#define SYMBOL_SIZE 8
+
+/** Rounds a size up to a multiple of 4 */
+#define ALIGN4(size) (((size) + 3) & ~3L)
+
+/** The ARE of each 2-bit code of the ARE plane */
+static const char are_by_code[] = "ARE";
+
+/**
+ * Puts a 16-bit number, little-endian
+ * @param dest Where to put it
+ * @param value The number
+ */
+static void put_u16(unsigned char *dest, unsigned long value) {
+	dest[0] = (unsigned char) (value & 0xFF);
+	dest[1] = (unsigned char) ((value >> 8) & 0xFF);
+}
+
+void put_u32(unsigned char *dest, unsigned long value) {
+	put_u16(dest, value & 0xFFFF);
+	put_u16(dest + 2, (value >> 16) & 0xFFFF);
+}
+
+/**
+ * Gets a 16-bit little-endian number
+ * @param src Where the number is
+ * @return The number
+ */
+static unsigned long get_u16(unsigned char *src) {
+	return (unsigned long) src[0] | ((unsigned long) src[1] << 8);
+}
+
+unsigned long get_u32(unsigned char *src) {
+	return get_u16(src) | (get_u16(src + 2) << 16);
+}
+
+/**
+ * Returns the size of the names of the symbols, each NUL-terminated
+ * @param symbols The symbols
+ * @param count The count of symbols
+ * @return The size in bytes
+ */
+static long names_size(object_symbol *symbols, long count) {
+	long i, size = 0;
+	for (i = 0; i < count; i++) size += strlen(symbols[i].name) + 1;
+	return size;
+}
+
+/**
+ * Puts symbols and their names, in the binary format
+ * @param dest Where to put the symbols
+ * @param strings The start of the strings section
+ * @param strings_used The size of the strings put so far, updated
+ * @param symbols The symbols
+ * @param count The count of symbols
+ */
+static void put_symbols(unsigned char *dest, unsigned char *strings, long *strings_used, object_symbol *symbols,
+                        long count) {
+	long i, length;
+	for (i = 0; i < count; i++, dest += SYMBOL_SIZE) {
+		length = strlen(symbols[i].name) + 1;
+		memcpy(strings + *strings_used, symbols[i].name, length);
+		put_u32(dest, *strings_used);
+		put_u32(dest + 4, symbols[i].address);
+		*strings_used += length;
+	}
+}
+
+/**
+ * Gets symbols from the binary format. Their names point into the strings.
+ * @param src Where the symbols are
+ * @param strings The strings section, NUL-terminated at it's end
+ * @param strings_size The size of the strings section
+ * @param count The count of symbols
+ * @param mem The arena to allocate the symbols from
+ * @return The symbols, or NULL if any of their names is out of the strings
+ */
+static object_symbol *get_symbols(unsigned char *src, char *strings, long strings_size, long count, arena *mem) {
+	long i;
+	unsigned long name_offset;
+	object_symbol *symbols = arena_alloc(mem, (count + 1) * sizeof(object_symbol));
+	for (i = 0; i < count; i++, src += SYMBOL_SIZE) {
+		name_offset = get_u32(src);
+		if (name_offset >= (unsigned long) strings_size) return NULL;
+		symbols[i].name = strings + name_offset;
+		symbols[i].address = (long) get_u32(src + 4);
+	}
+	return symbols;
+}
+
+void get_object_layout(long word_count, long entry_count, long external_count, long strings_size,
+                       object_layout *layout) {
+	layout->words = OBJECT_HEADER_SIZE;
+	layout->are = layout->words + ALIGN4(word_count * 2);
+	layout->entries = layout->are + ALIGN4((word_count + 3) / 4);
+	layout->externals = layout->entries + entry_count * SYMBOL_SIZE;
+	layout->strings = layout->externals + external_count * SYMBOL_SIZE;
+	layout->size = layout->strings + ALIGN4(strings_size);
+}
+
+long binary_object_size(object_module *module) {
+	object_layout layout;
+	get_object_layout(module->code_length + module->data_length, module->entry_count, module->external_count,
+	                  names_size(module->entries, module->entry_count) +
+	                  names_size(module->externals, module->external_count), &layout);
+	return layout.size;
+}
+
+void put_binary_object(unsigned char *dest, object_module *module) {
+	long i, word_count = module->code_length + module->data_length, strings_used = 0;
+	long strings_size = names_size(module->entries, module->entry_count) +
+	                    names_size(module->externals, module->external_count);
+	object_layout layout;
+	get_object_layout(word_count, module->entry_count, module->external_count, strings_size, &layout);
+	memset(dest, 0, layout.size);
+
+	memcpy(dest + MAGIC_OFFSET, OBJECT_MAGIC, 4);
+	put_u32(dest + VERSION_OFFSET, OBJECT_VERSION);
+	put_u32(dest + CODE_LENGTH_OFFSET, module->code_length);
+	put_u32(dest + DATA_LENGTH_OFFSET, module->data_length);
+	put_u32(dest + ENTRY_COUNT_OFFSET, module->entry_count);
+	put_u32(dest + EXTERNAL_COUNT_OFFSET, module->external_count);
+	put_u32(dest + STRINGS_SIZE_OFFSET, strings_size);
+	put_u32(dest + LOAD_ADDRESS_OFFSET, IC_INIT_VALUE);
+
+	for (i = 0; i < word_count; i++) {
+		put_u16(dest + layout.words + i * 2, module->words[i] & 0xFFF);
+		/* A is 0, so only R and E set bits */
+		if (module->are[i] == R_MEM) dest[layout.are + i / 4] |= 1 << (i % 4 * 2);
+		else if (module->are[i] == E_MEM) dest[layout.are + i / 4] |= 2 << (i % 4 * 2);
+	}
+	put_symbols(dest + layout.entries, dest + layout.strings, &strings_used, module->entries, module->entry_count);
+	put_symbols(dest + layout.externals, dest + layout.strings, &strings_used, module->externals,
+	            module->external_count);
+}
+
+bool get_binary_object(unsigned char *data, long size, object_module *module, arena *mem) {
+	long i, word_count, strings_size;
+	int are_code;
+	char *strings;
+	object_layout layout;
+	if (size < OBJECT_HEADER_SIZE || memcmp(data + MAGIC_OFFSET, OBJECT_MAGIC, 4) != 0 ||
+	    get_u32(data + VERSION_OFFSET) != OBJECT_VERSION || get_u32(data + LOAD_ADDRESS_OFFSET) != IC_INIT_VALUE) {
+		return FALSE;
+	}
+	/* With a 32-bit long, a huge count reads as negative */
+	module->code_length = (long) get_u32(data + CODE_LENGTH_OFFSET);
+	module->data_length = (long) get_u32(data + DATA_LENGTH_OFFSET);
+	module->entry_count = (long) get_u32(data + ENTRY_COUNT_OFFSET);
+	module->external_count = (long) get_u32(data + EXTERNAL_COUNT_OFFSET);
+	strings_size = (long) get_u32(data + STRINGS_SIZE_OFFSET);
+	word_count = module->code_length + module->data_length;
+	if (module->code_length < 0 || module->data_length < 0 || module->entry_count < 0 ||
+	    module->external_count < 0 || strings_size < 0) {
+		return FALSE;
+	}
+	get_object_layout(word_count, module->entry_count, module->external_count, strings_size, &layout);
+	if (layout.size > size || (strings_size > 0 && data[layout.strings + strings_size - 1] != '\0')) return FALSE;
+
+	module->words = arena_alloc(mem, (word_count + 1) * sizeof(unsigned int));
+	module->are = arena_alloc(mem, word_count + 1);
+	for (i = 0; i < word_count; i++) {
+		module->words[i] = (unsigned int) get_u16(data + layout.words + i * 2) & 0xFFF;
+		are_code = (data[layout.are + i / 4] >> (i % 4 * 2)) & 3;
+		if (are_code > 2) return FALSE;
+		module->are[i] = are_by_code[are_code];
+	}
+	/* The names are copied once, so the module doesn't depend on the data */
+	strings = arena_alloc(mem, strings_size + 1);
+	memcpy(strings, data + layout.strings, strings_size);
+	module->entries = get_symbols(data + layout.entries, strings, strings_size, module->entry_count, mem);
+	module->externals = get_symbols(data + layout.externals, strings, strings_size, module->external_count, mem);
+	return module->entries != NULL && module->externals != NULL;
+}
+
+bool read_binary_object(char *filename, object_module *module, arena *mem, FILE *output) {
+	long size;
+	bool is_success;
+	char *data = NULL;
+	char *full_filename = strallocat(filename, ".obj");
+	FILE *file_desc = fopen(full_filename, "rb");
+	is_success = file_desc != NULL && read_whole_file(file_desc, &data, &size);
+	if (!is_success) {
+		fprintf(output, "Error: file \"%s\" is inaccessible for reading.\n", full_filename);
+	} else if (!(is_success = get_binary_object((unsigned char *) data, size, module, mem))) {
+		fprintf(output, "Error: file \"%s\" is not a valid binary object.\n", full_filename);
+	}
+	if (file_desc != NULL) fclose(file_desc);
+	free(data);
+	free(full_filename);
+	return is_success;
+}
+
+/**
+ * Reads a whole text file of the object
+ * @param filename The filename, without the extension
+ * @param file_extension The extension of the file, including dot before
+ * @param source The source to read into
+ * @param required Whether a missing file is an error, rather than an empty one
+ * @param output The stream to print the errors to
+ * @return Whether succeeded
+ */
+static bool read_text_file(char *filename, char *file_extension, source_file *source, bool required, FILE *output) {
+	bool is_success = TRUE;
+	char *full_filename = strallocat(filename, file_extension);
+	FILE *file_desc = fopen(full_filename, "r");
+	source->text = NULL;
+	source->line_offsets = NULL;
+	source->line_count = 0;
+	if (file_desc != NULL) {
+		is_success = read_source(source, file_desc);
+		fclose(file_desc);
+	} else is_success = !required;
+	if (!is_success) fprintf(output, "Error: file \"%s\" is inaccessible for reading.\n", full_filename);
+	free(full_filename);
+	return is_success;
+}
+
+/**
+ * Reads the symbols of a text file (.ent or .ext) - each is a name and an address, separated by a space
+ * @param filename The filename, without the extension
+ * @param file_extension The extension of the file, including dot before
+ * @param count Where to return the count of symbols
+ * @param mem The arena to allocate from
+ * @param output The stream to print the errors to
+ * @return The symbols, or NULL if failed
+ */
+static object_symbol *read_text_symbols(char *filename, char *file_extension, long *count, arena *mem,
+                                        FILE *output) {
+	long i;
+	char *line, *separator, *end;
+	object_symbol *symbols;
+	source_file source;
+	if (!read_text_file(filename, file_extension, &source, FALSE, output)) {
+		free_source(&source);
+		return NULL;
+	}
+	symbols = arena_alloc(mem, (source.line_count + 1) * sizeof(object_symbol));
+	*count = 0;
+	for (i = 0; i < source.line_count; i++) {
+		line = source_line(&source, i);
+		if (*line == '\0') continue;
+		separator = strchr(line, ' ');
+		if (separator == NULL || separator == line) break;
+		*separator = '\0';
+		symbols[*count].name = arena_strdup(mem, line);
+		symbols[*count].address = strtol(separator + 1, &end, 10);
+		if (end == separator + 1 || *end != '\0') break;
+		(*count)++;
+	}
+	if (i < source.line_count) {
+		fprintf(output, "Error: file \"%s%s\" line %ld is not a symbol and an address.\n", filename, file_extension,
+		        i + 1);
+		symbols = NULL;
+	}
+	free_source(&source);
+	return symbols;
+}
+
+bool read_text_object(char *filename, object_module *module, arena *mem, FILE *output) {
+	long i, word_count = 0, address;
+	char *line, *end;
+	bool is_valid;
+	source_file source;
+	if (!read_text_file(filename, ".ob", &source, TRUE, output)) {
+		free_source(&source);
+		return FALSE;
+	}
+	/* The lengths on top, then "<address> <3 hex digits> <ARE>" for each word */
+	is_valid = source.line_count > 0;
+	if (is_valid) {
+		module->code_length = strtol(source_line(&source, 0), &end, 10);
+		module->data_length = strtol(end, &end, 10);
+		word_count = module->code_length + module->data_length;
+		is_valid = *end == '\0' && module->code_length >= 0 && module->data_length >= 0 &&
+		           word_count == source.line_count - 1;
+	}
+	if (is_valid) {
+		module->words = arena_alloc(mem, (word_count + 1) * sizeof(unsigned int));
+		module->are = arena_alloc(mem, word_count + 1);
+	}
+	for (i = 0; is_valid && i < word_count; i++) {
+		line = source_line(&source, i + 1);
+		address = strtol(line, &end, 10);
+		is_valid = address == IC_INIT_VALUE + i && *end == ' ';
+		if (is_valid) {
+			module->words[i] = (unsigned int) strtol(end + 1, &end, 16);
+			is_valid = module->words[i] <= 0xFFF && *end == ' ' && end[1] != '\0' &&
+			           strchr(are_by_code, end[1]) != NULL && end[2] == '\0';
+			if (is_valid) module->are[i] = end[1];
+		}
+	}
+	if (!is_valid) {
+		fprintf(output, "Error: file \"%s.ob\" is not a valid object file (line %ld).\n", filename, i + 1);
+	}
+	free_source(&source);
+	if (!is_valid) return FALSE;
+
+	module->entries = read_text_symbols(filename, ".ent", &module->entry_count, mem, output);
+	module->externals = read_text_symbols(filename, ".ext", &module->external_count, mem, output);
+	return module->entries != NULL && module->externals != NULL;
+}
+
+bool read_object(char *argument, object_module *module, arena *mem, FILE *output) {
+	bool is_success;
+	long length = strlen(argument);
+	char *filename = calloc_with_check(length + 1);
+	bool binary = length > 4 && strcmp(argument + length - 4, ".obj") == 0;
+	/* The extension is optional for the text files */
+	if (binary) length -= 4;
+	else if (length > 3 && strcmp(argument + length - 3, ".ob") == 0) length -= 3;
+	strncpy(filename, argument, length);
+	is_success = binary ? read_binary_object(filename, module, mem, output)
+	                    : read_text_object(filename, module, mem, output);
+	free(filename);
+	return is_success;
+}
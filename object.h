@@ -0,0 +1,145 @@
+/* Implements the object module of an assembled file, and it's compact binary format (.obj) */
+#ifndef _OBJECT_H
+#define _OBJECT_H
+#include <stdio.h>
+#include "globals.h"
+#include "arena.h"
+
+/*
+ * The binary format has a fixed layout, so every field is at an offset known from the header,
+ * and a file can be used in place (e.g. mapped into memory) without parsing it.
+ * All the numbers are little-endian, and every section starts at a multiple of 4 bytes:
+ *   header    - OBJECT_HEADER_SIZE bytes: magic, version, code length, data length,
+ *               entry count, external count, strings size, load address (4 bytes each)
+ *   words     - 2 bytes per word, it's 12-bit value
+ *   ARE plane - 2 bits per word, 4 words per byte (from the lowest bits): 0 = A, 1 = R, 2 = E
+ *   entries   - 8 bytes per entry: offset of it's name in the strings, address
+ *   externals - 8 bytes per external reference, the same as the entries
+ *   strings   - the names, each NUL-terminated
+ */
+
+/** The first bytes of a binary object */
+#define OBJECT_MAGIC "A12O"
+
+/** The version of the binary format */
+#define OBJECT_VERSION 1
+
+/** Size of the binary header, in bytes */
+#define OBJECT_HEADER_SIZE 32
+
+/** A symbol of an object - an entry, or a reference to an external symbol */
+typedef struct object_symbol {
+	/** The symbol name */
+	char *name;
+	/** The address of the entry, or of the word that refers to the external */
+	long address;
+} object_symbol;
+
+/** An assembled file - it's memory image and it's symbols */
+typedef struct object_module {
+	/** Count of code words and of data words. The data follows the code, from IC_INIT_VALUE */
+	long code_length;
+	long data_length;
+	/** The 12-bit value of each word */
+	unsigned int *words;
+	/** The ARE of each word ('A', 'R' or 'E') */
+	char *are;
+	/** The entries, and the references to external symbols - both by address */
+	object_symbol *entries;
+	long entry_count;
+	object_symbol *externals;
+	long external_count;
+} object_module;
+
+/** Offsets of the sections of a binary object */
+typedef struct object_layout {
+	long words;
+	long are;
+	long entries;
+	long externals;
+	long strings;
+	/** Size of the whole object */
+	long size;
+} object_layout;
+
+/**
+ * Puts a 32-bit number, little-endian
+ * @param dest Where to put it
+ * @param value The number
+ */
+void put_u32(unsigned char *dest, unsigned long value);
+
+/**
+ * Gets a 32-bit little-endian number
+ * @param src Where the number is
+ * @return The number
+ */
+unsigned long get_u32(unsigned char *src);
+
+/**
+ * Computes the offsets of the sections of a binary object
+ * @param word_count The count of words (code and data)
+ * @param entry_count The count of entries
+ * @param external_count The count of external references
+ * @param strings_size The size of the strings, in bytes
+ * @param layout The layout to fill
+ */
+void get_object_layout(long word_count, long entry_count, long external_count, long strings_size,
+                       object_layout *layout);
+
+/**
+ * Returns the size of a module in the binary format
+ * @param module The module
+ * @return The size in bytes
+ */
+long binary_object_size(object_module *module);
+
+/**
+ * Puts a module into a buffer, in the binary format
+ * @param dest The buffer, of binary_object_size bytes
+ * @param module The module
+ */
+void put_binary_object(unsigned char *dest, object_module *module);
+
+/**
+ * Reads a module from a binary object in memory
+ * @param data The binary object
+ * @param size The size of the binary object
+ * @param module The module to read into. The words and the symbols are allocated from the arena
+ * @param mem The arena to allocate from
+ * @return Whether the binary object is valid
+ */
+bool get_binary_object(unsigned char *data, long size, object_module *module, arena *mem);
+
+/**
+ * Reads a module from it's binary object file (.obj)
+ * @param filename The filename, without the extension
+ * @param module The module to read into
+ * @param mem The arena to allocate the module from
+ * @param output The stream to print the errors to
+ * @return Whether succeeded
+ */
+bool read_binary_object(char *filename, object_module *module, arena *mem, FILE *output);
+
+/**
+ * Reads a module from it's text files - the .ob file, and the .ent and .ext files if exist
+ * @param filename The filename, without the extension
+ * @param module The module to read into
+ * @param mem The arena to allocate the module from
+ * @param output The stream to print the errors to
+ * @return Whether succeeded
+ */
+bool read_text_object(char *filename, object_module *module, arena *mem, FILE *output);
+
+/**
+ * Reads a module by a file name of the arguments - from it's binary object if it's an .obj file, and from it's text
+ * files otherwise (the .ob extension is optional)
+ * @param argument The file name, as given in the arguments
+ * @param module The module to read into
+ * @param mem The arena to allocate the module from
+ * @param output The stream to print the errors to
+ * @return Whether succeeded
+ */
+bool read_object(char *argument, object_module *module, arena *mem, FILE *output);
+
+#endif
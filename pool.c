@@ -0,0 +1,155 @@
+/* Implements a pool of worker threads: each worker has a queue of jobs, and steals from the others when it's empty. */
+#define _POSIX_C_SOURCE 200112L
+#include <stdlib.h>
+#include <pthread.h>
+#include "pool.h"
+#include "utils.h"
+
+/** The jobs of a single worker - the worker takes from the head, thieves take from the tail */
+typedef struct job_queue {
+	long *jobs;
+	long head;
+	long tail;
+	pthread_mutex_t lock;
+} job_queue;
+
+/** The shared state of the pool */
+typedef struct pool {
+	/** A queue for each worker */
+	job_queue *queues;
+	int worker_count;
+	/** Whether each job is done, guarded by done_lock */
+	bool *done;
+	pthread_mutex_t done_lock;
+	pthread_cond_t done_changed;
+	job_function run;
+	void *context;
+} pool;
+
+/** The argument of a worker thread */
+typedef struct worker {
+	pool *owner;
+	int index;
+} worker;
+
+/**
+ * Takes a job from a queue
+ * @param queue The queue
+ * @param from_head Whether to take from the head (the owner) or from the tail (a thief)
+ * @return The job, -1 if the queue is empty
+ */
+static long take_job(job_queue *queue, bool from_head) {
+	long job = -1;
+	pthread_mutex_lock(&queue->lock);
+	if (queue->head < queue->tail) {
+		job = from_head ? queue->jobs[queue->head++] : queue->jobs[--queue->tail];
+	}
+	pthread_mutex_unlock(&queue->lock);
+	return job;
+}
+
+/**
+ * Returns the next job of a worker: from it's own queue, or stolen from the others
+ * @param owner The pool
+ * @param index The index of the worker
+ * @return The job, -1 if there are no jobs left at all
+ */
+static long next_job(pool *owner, int index) {
+	int i;
+	long job;
+	if ((job = take_job(&owner->queues[index], TRUE)) >= 0) return job;
+	/* No jobs are added while running, so once every queue is empty, the worker is done */
+	for (i = 1; i < owner->worker_count; i++) {
+		if ((job = take_job(&owner->queues[(index + i) % owner->worker_count], FALSE)) >= 0) return job;
+	}
+	return -1;
+}
+
+/**
+ * The thread function of a worker
+ * @param arg The worker
+ * @return NULL
+ */
+static void *worker_main(void *arg) {
+	worker *self = arg;
+	pool *owner = self->owner;
+	long job;
+	while ((job = next_job(owner, self->index)) >= 0) {
+		owner->run(job, self->index, owner->context);
+		pthread_mutex_lock(&owner->done_lock);
+		owner->done[job] = TRUE;
+		pthread_cond_broadcast(&owner->done_changed);
+		pthread_mutex_unlock(&owner->done_lock);
+	}
+	return NULL;
+}
+
+void run_jobs(long job_count, int worker_count, job_function run, job_function report, void *context) {
+	pool owner;
+	worker *workers;
+	pthread_t *threads;
+	bool *started;
+	int i, started_count = 0;
+	long job;
+
+	if (worker_count > job_count) worker_count = (int) job_count;
+	if (worker_count > 1) {
+		owner.worker_count = worker_count;
+		owner.run = run;
+		owner.context = context;
+		owner.done = calloc_with_check(job_count * sizeof(bool));
+		owner.queues = calloc_with_check(worker_count * sizeof(job_queue));
+		workers = calloc_with_check(worker_count * sizeof(worker));
+		threads = calloc_with_check(worker_count * sizeof(pthread_t));
+		started = calloc_with_check(worker_count * sizeof(bool));
+		pthread_mutex_init(&owner.done_lock, NULL);
+		pthread_cond_init(&owner.done_changed, NULL);
+		for (i = 0; i < worker_count; i++) {
+			owner.queues[i].jobs = calloc_with_check((job_count / worker_count + 1) * sizeof(long));
+			owner.queues[i].head = owner.queues[i].tail = 0;
+			pthread_mutex_init(&owner.queues[i].lock, NULL);
+		}
+		/* Deal the jobs round-robin, so the first jobs (which are reported first) are taken first */
+		for (job = 0; job < job_count; job++) {
+			job_queue *queue = &owner.queues[job % worker_count];
+			queue->jobs[queue->tail++] = job;
+		}
+		for (i = 0; i < worker_count; i++) {
+			workers[i].owner = &owner;
+			workers[i].index = i;
+			if (pthread_create(&threads[i], NULL, worker_main, &workers[i]) == 0) {
+				started[i] = TRUE;
+				started_count++;
+			}
+		}
+		/* The workers that did start steal the jobs of the ones that didn't */
+		if (started_count > 0) {
+			for (job = 0; job < job_count; job++) {
+				pthread_mutex_lock(&owner.done_lock);
+				while (!owner.done[job]) pthread_cond_wait(&owner.done_changed, &owner.done_lock);
+				pthread_mutex_unlock(&owner.done_lock);
+				report(job, -1, context);
+			}
+			for (i = 0; i < worker_count; i++) {
+				if (started[i]) pthread_join(threads[i], NULL);
+			}
+		}
+		for (i = 0; i < worker_count; i++) {
+			pthread_mutex_destroy(&owner.queues[i].lock);
+			free(owner.queues[i].jobs);
+		}
+		pthread_mutex_destroy(&owner.done_lock);
+		pthread_cond_destroy(&owner.done_changed);
+		free(owner.done);
+		free(owner.queues);
+		free(workers);
+		free(threads);
+		free(started);
+		if (started_count > 0) return;
+	}
+	/* A single worker (or no threads at all) - just run everything in order */
+	for (job = 0; job < job_count; job++) {
+		run(job, 0, context);
+		report(job, -1, context);
+	}
+}
@@ -0,0 +1,27 @@
+/* Implements a pool of worker threads, which run numbered jobs with work stealing */
+#ifndef _POOL_H
+#define _POOL_H
+#include "globals.h"
+
+/**
+ * A single job (or it's report)
+ * @param job The index of the job
+ * @param worker The index of the worker that runs it (-1 for reports)
+ * @param context The context that was passed to run_jobs
+ */
+typedef void (*job_function)(long job, int worker, void *context);
+
+/**
+ * Runs the jobs 0..job_count-1 on worker_count workers, and reports each of them on the calling thread.
+ * Each worker runs it's own jobs first, and steals from the others when it's out of jobs.
+ * Reports are always called in the jobs order, as soon as the job and all the ones before it are done.
+ * With a single worker, the jobs run on the calling thread, with each report right after it's job.
+ * @param job_count The count of jobs
+ * @param worker_count The count of workers
+ * @param run The job itself
+ * @param report The report of a finished job
+ * @param context A context to pass to run and report
+ */
+void run_jobs(long job_count, int worker_count, job_function run, job_function report, void *context);
+
+#endif
@@ -0,0 +1,149 @@
+/* Implements the frames of the assembler daemon's protocol, and the requests & responses in them */
+/* send & MSG_NOSIGNAL, so a client that went away doesn't kill the daemon */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include "protocol.h"
+#include "object.h"
+#include "utils.h"
+
+/** Size of a request's fields before the payload: the kind, and the maximum count of errors */
+#define REQUEST_HEADER_SIZE 8
+
+/** Size of a response's fields before the binary object: the status, whether the maximum count of errors was reached,
+ * the diagnostics count and the object size */
+#define RESPONSE_HEADER_SIZE 16
+
+/** Size of a diagnostic's fields before the message: the line number, and the message's length */
+#define DIAGNOSTIC_HEADER_SIZE 8
+
+bool send_frame(int fd, unsigned char *frame, long size) {
+	ssize_t sent;
+	while (size > 0) {
+		if ((sent = send(fd, frame, size, MSG_NOSIGNAL)) < 0) {
+			if (errno == EINTR) continue;
+			return FALSE;
+		}
+		frame += sent;
+		size -= sent;
+	}
+	return TRUE;
+}
+
+/**
+ * Receives exactly a count of bytes
+ * @param fd The socket
+ * @param dest Where to receive them to
+ * @param size The count of bytes
+ * @return Whether all of them were received
+ */
+static bool receive_all(int fd, unsigned char *dest, long size) {
+	ssize_t received;
+	while (size > 0) {
+		if ((received = read(fd, dest, size)) <= 0) {
+			if (received < 0 && errno == EINTR) continue;
+			return FALSE;
+		}
+		dest += received;
+		size -= received;
+	}
+	return TRUE;
+}
+
+bool receive_frame(int fd, unsigned char **content, long *size) {
+	unsigned char header[FRAME_HEADER_SIZE];
+	if (!receive_all(fd, header, FRAME_HEADER_SIZE)) return FALSE;
+	*size = (long) get_u32(header);
+	if (*size > MAX_FRAME_SIZE) return FALSE;
+	if ((*content = calloc(1, *size + 1)) == NULL) return FALSE;
+	if (!receive_all(fd, *content, *size)) {
+		free(*content);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+unsigned char *put_request(job_kind kind, assemble_options *options, const char *payload, long length, long *size) {
+	unsigned char *frame;
+	*size = FRAME_HEADER_SIZE + REQUEST_HEADER_SIZE + length;
+	frame = calloc_with_check(*size);
+	put_u32(frame, *size - FRAME_HEADER_SIZE);
+	put_u32(frame + FRAME_HEADER_SIZE, kind);
+	put_u32(frame + FRAME_HEADER_SIZE + 4, options->max_errors);
+	memcpy(frame + FRAME_HEADER_SIZE + REQUEST_HEADER_SIZE, payload, length);
+	return frame;
+}
+
+bool get_request(unsigned char *content, long size, job_request *request) {
+	if (size < REQUEST_HEADER_SIZE) return FALSE;
+	request->kind = (job_kind) get_u32(content);
+	request->options.max_errors = (long) get_u32(content + 4);
+	request->payload = (char *) content + REQUEST_HEADER_SIZE;
+	request->length = size - REQUEST_HEADER_SIZE;
+	return request->kind == SOURCE_JOB || request->kind == PATH_JOB;
+}
+
+unsigned char *put_response(job_status status, assemble_result *result, long *size) {
+	long i, object_size = 0, message_length;
+	bool assembled = status == JOB_SUCCEEDED || status == JOB_FAILED;
+	unsigned char *frame, *curr;
+	if (status == JOB_SUCCEEDED) object_size = binary_object_size(&result->module);
+	*size = FRAME_HEADER_SIZE + RESPONSE_HEADER_SIZE + object_size;
+	for (i = 0; assembled && i < result->diagnostic_count; i++) {
+		*size += DIAGNOSTIC_HEADER_SIZE + strlen(result->diagnostics[i].message);
+	}
+
+	if ((frame = calloc(1, *size)) == NULL) return NULL;
+	put_u32(frame, *size - FRAME_HEADER_SIZE);
+	put_u32(frame + FRAME_HEADER_SIZE, status);
+	put_u32(frame + FRAME_HEADER_SIZE + 4, assembled && result->reached_max_errors);
+	put_u32(frame + FRAME_HEADER_SIZE + 8, assembled ? result->diagnostic_count : 0);
+	put_u32(frame + FRAME_HEADER_SIZE + 12, object_size);
+	curr = frame + FRAME_HEADER_SIZE + RESPONSE_HEADER_SIZE;
+	if (object_size > 0) put_binary_object(curr, &result->module);
+	curr += object_size;
+	for (i = 0; assembled && i < result->diagnostic_count; i++) {
+		message_length = strlen(result->diagnostics[i].message);
+		put_u32(curr, result->diagnostics[i].line_number);
+		put_u32(curr + 4, message_length);
+		memcpy(curr + DIAGNOSTIC_HEADER_SIZE, result->diagnostics[i].message, message_length);
+		curr += DIAGNOSTIC_HEADER_SIZE + message_length;
+	}
+	return frame;
+}
+
+bool get_response(unsigned char *content, long size, job_status *status, assemble_result *result) {
+	long i, object_size, message_length;
+	unsigned char *curr, *end = content + size;
+	arena_reset(&result->mem);
+	memset(&result->module, 0, sizeof(object_module));
+	if (size < RESPONSE_HEADER_SIZE) return FALSE;
+	*status = (job_status) get_u32(content);
+	result->succeeded = *status == JOB_SUCCEEDED;
+	result->reached_max_errors = get_u32(content + 4) != 0;
+	result->diagnostic_count = (long) get_u32(content + 8);
+	object_size = (long) get_u32(content + 12);
+	curr = content + RESPONSE_HEADER_SIZE;
+	if (object_size > end - curr || result->diagnostic_count > (end - curr) / DIAGNOSTIC_HEADER_SIZE ||
+	    (object_size > 0 && !get_binary_object(curr, object_size, &result->module, &result->mem))) {
+		return FALSE;
+	}
+	curr += object_size;
+
+	result->diagnostics = arena_alloc(&result->mem, (result->diagnostic_count + 1) * sizeof(assemble_diagnostic));
+	for (i = 0; i < result->diagnostic_count; i++) {
+		if (end - curr < DIAGNOSTIC_HEADER_SIZE) return FALSE;
+		result->diagnostics[i].line_number = (long) get_u32(curr);
+		message_length = (long) get_u32(curr + 4);
+		curr += DIAGNOSTIC_HEADER_SIZE;
+		if (message_length > end - curr) return FALSE;
+		result->diagnostics[i].message = arena_alloc(&result->mem, message_length + 1);
+		memcpy(result->diagnostics[i].message, curr, message_length);
+		curr += message_length;
+	}
+	return curr == end;
+}
@@ -0,0 +1,105 @@
+/* Implements the protocol of the assembler daemon (asmd) and it's client (asmc), over a Unix domain socket.
+ * Each message is a frame: it's size (a 32-bit little-endian number), then it's content.
+ * A request is: the job's kind, the maximum count of errors (0 for unlimited), then the source (or it's path).
+ * A response is: the job's status, whether the maximum count of errors was reached, the count of diagnostics, the size
+ * of the binary object (0 if failed), the binary object, then each diagnostic - it's line number, the length of it's message, and the message. */
+#ifndef _PROTOCOL_H
+#define _PROTOCOL_H
+#include "globals.h"
+#include "assemble.h"
+
+/** Where the daemon listens, unless told otherwise (--socket PATH) */
+#define DEFAULT_SOCKET_PATH "/tmp/asmd.socket"
+
+/** Size of the header of a frame - it's size */
+#define FRAME_HEADER_SIZE 4
+
+/** Maximum size of a frame's content - anything bigger is a broken peer */
+#define MAX_FRAME_SIZE (256L * 1024 * 1024)
+
+/** What a request holds */
+typedef enum job_kind {
+	/** The source itself */
+	SOURCE_JOB,
+	/** The path of the source, which the daemon reads */
+	PATH_JOB
+} job_kind;
+
+/** How a job ended */
+typedef enum job_status {
+	JOB_FAILED,
+	JOB_SUCCEEDED,
+	/** The path of the source couldn't be read */
+	JOB_UNREADABLE,
+	/** The request itself is broken */
+	JOB_INVALID
+} job_status;
+
+/** A request, as received */
+typedef struct job_request {
+	job_kind kind;
+	/** The assembling options */
+	assemble_options options;
+	/** The source, or it's path (NUL-terminated, within the received frame) */
+	char *payload;
+	long length;
+} job_request;
+
+/**
+ * Sends a whole frame
+ * @param fd The socket
+ * @param frame The frame, from it's header
+ * @param size The size of the frame, with it's header
+ * @return Whether succeeded
+ */
+bool send_frame(int fd, unsigned char *frame, long size);
+
+/**
+ * Receives a frame's content
+ * @param fd The socket
+ * @param content Where to return the content, NUL-terminated. Must be deallocated if succeeded
+ * @param size Where to return the size of the content
+ * @return Whether a frame was received (FALSE at the end of the connection, as well as if failed or out of memory)
+ */
+bool receive_frame(int fd, unsigned char **content, long *size);
+
+/**
+ * Builds the frame of a request
+ * @param kind What the payload is
+ * @param options The assembling options
+ * @param payload The source, or it's path
+ * @param length The length of the payload
+ * @param size Where to return the size of the frame
+ * @return The new frame
+ */
+unsigned char *put_request(job_kind kind, assemble_options *options, const char *payload, long length, long *size);
+
+/**
+ * Reads a request from a received frame's content
+ * @param content The content (NUL-terminated, as received)
+ * @param size The size of the content
+ * @param request The request to fill - it's payload points into the content
+ * @return Whether the request is valid
+ */
+bool get_request(unsigned char *content, long size, job_request *request);
+
+/**
+ * Builds the frame of a response
+ * @param status How the job ended
+ * @param result The result of assembling the source (ignored unless the job was assembled)
+ * @param size Where to return the size of the frame
+ * @return The new frame, or NULL if out of memory
+ */
+unsigned char *put_response(job_status status, assemble_result *result, long *size);
+
+/**
+ * Reads a response from a received frame's content
+ * @param content The content
+ * @param size The size of the content
+ * @param status Where to return how the job ended
+ * @param result The result to fill, allocated from it's arena (which is reset first)
+ * @return Whether the response is valid
+ */
+bool get_response(unsigned char *content, long size, job_status *status, assemble_result *result);
+
+#endif
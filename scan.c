@@ -0,0 +1,184 @@
+/* Implements the line classifier. Each block of 32 chars is compared against every delimiter at once - by AVX2 or SSE2,
+ * picked by the CPU at runtime - and the results are kept as bitmasks, which the lookups go over by counting zeros.
+ * Building with SCALAR_SCAN (or for a CPU other than x86) classifies char by char instead. */
+#include "scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) && !defined(SCALAR_SCAN)
+#define SIMD_SCAN
+#include <immintrin.h>
+#endif
+
+/** Classifies a single block of a line into the masks */
+typedef void (*block_classifier)(const char *block, line_masks *masks, int word);
+
+/**
+ * Classifies a block char by char
+ * @param block The block's chars
+ * @param masks The masks to fill
+ * @param word The index of the block in the line
+ */
+static void classify_scalar(const char *block, line_masks *masks, int word) {
+	int i, class;
+	for (i = 0; i < SCAN_BLOCK_SIZE; i++) {
+		switch (block[i]) {
+			case ' ':
+			case '\t':
+				class = WHITE_CLASS;
+				break;
+			case ',':
+				class = COMMA_CLASS;
+				break;
+			case ':':
+				class = COLON_CLASS;
+				break;
+			case '"':
+				class = QUOTE_CLASS;
+				break;
+			case ';':
+				class = COMMENT_CLASS;
+				break;
+			case '\0':
+				class = END_CLASS;
+				break;
+			case '\n':
+			case (char) EOF:
+				class = NEWLINE_CLASS;
+				break;
+			default:
+				continue;
+		}
+		masks->words[class][word] |= 1u << i;
+	}
+}
+
+#ifdef SIMD_SCAN
+/** The bits of the chars of a 16-char vector that equal a char */
+#define SSE2_MATCH(chars, c) ((unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8((chars), _mm_set1_epi8(c))))
+
+/** The bits of the chars of a 32-char vector that equal a char */
+#define AVX2_MATCH(chars, c) ((unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8((chars), _mm256_set1_epi8(c))))
+
+/**
+ * Classifies a block by SSE2 - as two halves of 16 chars
+ * @param block The block's chars
+ * @param masks The masks to fill
+ * @param word The index of the block in the line
+ */
+static void classify_sse2(const char *block, line_masks *masks, int word) {
+	int half;
+	__m128i chars;
+	for (half = 0; half < 2; half++) {
+		chars = _mm_loadu_si128((const __m128i *) (block + half * 16));
+		masks->words[WHITE_CLASS][word] |= (SSE2_MATCH(chars, ' ') | SSE2_MATCH(chars, '\t')) << (half * 16);
+		masks->words[COMMA_CLASS][word] |= SSE2_MATCH(chars, ',') << (half * 16);
+		masks->words[COLON_CLASS][word] |= SSE2_MATCH(chars, ':') << (half * 16);
+		masks->words[QUOTE_CLASS][word] |= SSE2_MATCH(chars, '"') << (half * 16);
+		masks->words[COMMENT_CLASS][word] |= SSE2_MATCH(chars, ';') << (half * 16);
+		masks->words[END_CLASS][word] |= SSE2_MATCH(chars, '\0') << (half * 16);
+		masks->words[NEWLINE_CLASS][word] |= (SSE2_MATCH(chars, '\n') | SSE2_MATCH(chars, (char) EOF)) << (half * 16);
+	}
+}
+
+/**
+ * Classifies a block by AVX2 - all of it's chars at once
+ * @param block The block's chars
+ * @param masks The masks to fill
+ * @param word The index of the block in the line
+ */
+__attribute__((target("avx2"))) static void classify_avx2(const char *block, line_masks *masks, int word) {
+	__m256i chars = _mm256_loadu_si256((const __m256i *) block);
+	masks->words[WHITE_CLASS][word] = AVX2_MATCH(chars, ' ') | AVX2_MATCH(chars, '\t');
+	masks->words[COMMA_CLASS][word] = AVX2_MATCH(chars, ',');
+	masks->words[COLON_CLASS][word] = AVX2_MATCH(chars, ':');
+	masks->words[QUOTE_CLASS][word] = AVX2_MATCH(chars, '"');
+	masks->words[COMMENT_CLASS][word] = AVX2_MATCH(chars, ';');
+	masks->words[END_CLASS][word] = AVX2_MATCH(chars, '\0');
+	masks->words[NEWLINE_CLASS][word] = AVX2_MATCH(chars, '\n') | AVX2_MATCH(chars, (char) EOF);
+}
+#endif
+
+/** The fastest classifier the CPU supports - the scalar one if it has no SIMD (or wasn't built for it) */
+static block_classifier classify = classify_scalar;
+
+#ifdef SIMD_SCAN
+/**
+ * Picks the classifier for the CPU, once - when the program is loaded, before any thread scans a line
+ */
+__attribute__((constructor)) static void pick_classifier(void) {
+	/* Constructors may run before the runtime detects the CPU */
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) classify = classify_avx2;
+	else if (__builtin_cpu_supports("sse2")) classify = classify_sse2;
+}
+#endif
+
+void scan_line(const char *content, long length, line_masks *masks) {
+	int word, class;
+	if (length > MAX_LINE_LENGTH) length = MAX_LINE_LENGTH;
+	/* Up to the block of the terminator */
+	masks->word_count = (int) (length + SCAN_BLOCK_SIZE) / SCAN_BLOCK_SIZE;
+	for (word = 0; word < masks->word_count; word++) {
+		for (class = 0; class < CLASS_COUNT; class++) masks->words[class][word] = 0;
+		classify(content + word * SCAN_BLOCK_SIZE, masks, word);
+	}
+}
+
+/**
+ * Returns the bits of a word of the line which are of any of the classes
+ * @param masks The masks of the line
+ * @param classes The classes, as a mask of CLASS_MASK(class) values
+ * @param word The index of the word
+ * @return The bits
+ */
+static unsigned int class_bits(line_masks *masks, unsigned int classes, int word) {
+	int class;
+	unsigned int bits = 0;
+	for (class = 0; class < CLASS_COUNT; class++) {
+		if (classes & CLASS_MASK(class)) bits |= masks->words[class][word];
+	}
+	return bits;
+}
+
+/**
+ * Returns the index of the lowest set bit
+ * @param bits The bits, not 0
+ * @return The index of the bit
+ */
+static int lowest_bit(unsigned int bits) {
+#ifdef __GNUC__
+	return __builtin_ctz(bits);
+#else
+	int i;
+	for (i = 0; !(bits & 1u); i++) bits >>= 1;
+	return i;
+#endif
+}
+
+/**
+ * Returns the first bit of the chars from an index on, of the chars of any of the classes or of none of them
+ * @param masks The masks of the line
+ * @param classes The classes, as a mask of CLASS_MASK(class) values
+ * @param from The index to start from
+ * @param inverse Whether to look for a char of none of the classes
+ * @return The index of the found char, or the end of the classified blocks if there's none
+ */
+static int find_bit(line_masks *masks, unsigned int classes, int from, bool inverse) {
+	int word;
+	unsigned int bits;
+	for (word = from / SCAN_BLOCK_SIZE; word < masks->word_count; word++) {
+		bits = class_bits(masks, classes, word);
+		if (inverse) bits = ~bits;
+		/* Ignore the chars before the index */
+		if (word == from / SCAN_BLOCK_SIZE) bits &= ~0u << (from % SCAN_BLOCK_SIZE);
+		if (bits != 0) return word * SCAN_BLOCK_SIZE + lowest_bit(bits);
+	}
+	return masks->word_count * SCAN_BLOCK_SIZE;
+}
+
+int find_class(line_masks *masks, unsigned int classes, int from) {
+	return find_bit(masks, classes, from, FALSE);
+}
+
+int skip_class(line_masks *masks, unsigned int classes, int from) {
+	return find_bit(masks, classes, from, TRUE);
+}
@@ -0,0 +1,66 @@
+/* Classifies the chars of a source line into bitmasks in a single pass - by SIMD blocks when the CPU supports it -
+ * so the lexer jumps between the boundaries of the tokens, instead of going over the line char by char */
+#ifndef _SCAN_H
+#define _SCAN_H
+#include "globals.h"
+
+/** Count of chars the classifier reads at once. A line is read in whole blocks, even past it's end */
+#define SCAN_BLOCK_SIZE 32
+
+/** Count of blocks (32-bit mask words) of the longest line, with it's terminator */
+#define LINE_MASK_WORDS ((MAX_LINE_LENGTH + SCAN_BLOCK_SIZE) / SCAN_BLOCK_SIZE)
+
+/** The classes of the chars that split a line into tokens */
+typedef enum char_class {
+	/** Spaces and tabs */
+	WHITE_CLASS,
+	COMMA_CLASS,
+	COLON_CLASS,
+	QUOTE_CLASS,
+	/** ';', which starts a comment */
+	COMMENT_CLASS,
+	/** The terminator of the line */
+	END_CLASS,
+	/** Line breaks, and the EOF char - the parsers stop on them as well */
+	NEWLINE_CLASS,
+	CLASS_COUNT
+} char_class;
+
+/** Builds a classes mask for the lookups from a single class */
+#define CLASS_MASK(class) (1u << (class))
+
+/** The bitmasks of a line - bit i of the j'th word of a class is set if char (j * 32 + i) is of the class */
+typedef struct line_masks {
+	unsigned int words[CLASS_COUNT][LINE_MASK_WORDS];
+	/** Count of the words that were classified */
+	int word_count;
+} line_masks;
+
+/**
+ * Classifies the chars of a line
+ * @param content The line, NUL-terminated. It must be readable up to the end of the block of it's terminator
+ *                (the source's text is padded for that)
+ * @param length The length of the line - at most MAX_LINE_LENGTH
+ * @param masks The masks to fill
+ */
+void scan_line(const char *content, long length, line_masks *masks);
+
+/**
+ * Returns the first char of any of the classes, from an index on
+ * @param masks The masks of the line
+ * @param classes The classes to look for, as a mask of CLASS_MASK(class) values
+ * @param from The index to start looking from
+ * @return The index of the found char (there's always a terminator to find)
+ */
+int find_class(line_masks *masks, unsigned int classes, int from);
+
+/**
+ * Returns the first char that isn't of any of the classes, from an index on
+ * @param masks The masks of the line
+ * @param classes The classes to skip, as a mask of CLASS_MASK(class) values
+ * @param from The index to start skipping from
+ * @return The index of the found char
+ */
+int skip_class(line_masks *masks, unsigned int classes, int from);
+
+#endif
@@ -5,170 +5,119 @@
 #include "utils.h"
 #include "string.h"
 
-int process_spass_operand(line_info line, long *curr_ic, long *ic, char *operand, machine_word **memory_img,
-                          table *symbol_table);
+/**
+ * Resolves a single .entry line - adds the symbol to the table as an entry
+ * @param line The source line of the .entry instruction
+ * @param names The names table
+ * @param name The id of the symbol name
+ * @param symbol_table The symbol table
+ * @return Whether succeeded
+ */
+static bool process_entry_line(line_info line, name_table *names, long name, table *symbol_table);
 
 /**
- * Processes a single line in the second pass
- * @param line The line string
- * @param ic A pointer to instruction counter
- * @param memory_img Code image
+ * Builds the additional data word for an operand that uses a symbol.
+ * @param line The source line of the instruction
+ * @param instruction_address The address of the instruction's code word
+ * @param address The address of the data word
+ * @param addressing The addressing of the operand (direct or relative)
+ * @param name The id of the symbol name
+ * @param memory_img The code image array
  * @param symbol_table The symbol table
- * @return Whether operation succeeded
+ * @param mem The arena to allocate the data word from
+ * @return Whether succeeded
  */
-bool process_line_spass(line_info line, long *ic, machine_word **memory_img, table *symbol_table) {
-	char *indexOfColon;
-	char *token;
-	long i = 0;
-	MOVE_TO_NOT_WHITE(line.content, i)
-	/* Empty/Comment line - no processing needed! */
-	if (line.content[i] == ';' || line.content[i] == '\n') return TRUE;
-	indexOfColon = strchr(line.content, ':');
-	/*check for label */
-	if (indexOfColon != NULL) {
-		i = indexOfColon - line.content;
-		i++;
-	}
-	MOVE_TO_NOT_WHITE(line.content, i)
+static bool process_symbol_operand(line_info line, long instruction_address, long address, addressing_type addressing,
+                                   long name, machine_word **memory_img, table *symbol_table, arena *mem);
 
-	/* .instruction */
-	if (line.content[i] == '.') {
-		/*if it's entry we add it to the symbol table*/
-		if (strncmp(".entry", line.content, 6) == 0) {
-			i += 6;
-			MOVE_TO_NOT_WHITE(line.content, i)
-			token = strtok(line.content + i, " \n\t");
-			/* if label is already marked as entry, ignore. */
-			if (token == NULL) {
-				printf_line_error(line, "You have to specify a label name for .entry instruction.");
-				return FALSE;
-			}
-			if (find_by_types(*symbol_table, token, 1, ENTRY_SYMBOL) == NULL) {
-				table_entry *entry;
-				token = strtok(line.content + i, "\n"); /*get name of label*/
-				if (token[0] == '&') token++;
-				/* if symbol is not defined as data/code */
-				if ((entry = find_by_types(*symbol_table, token, 2, DATA_SYMBOL, CODE_SYMBOL)) == NULL) {
-					/* if defined as external print error */
-					if ((entry = find_by_types(*symbol_table, token, 1, EXTERNAL_SYMBOL)) != NULL) {
-						printf_line_error(line, "The symbol %s can be either external or entry, but not both.",
-						                  entry->key);
-						return FALSE;
-					}
-					/* otherwise print more general error */
-					printf_line_error(line, "The symbol %s for .entry is undefined.", token);
-					return FALSE;
+bool resolve_symbols(ir_list *ir, name_table *names, line_info line, machine_word **memory_img, table *symbol_table,
+                     arena *mem) {
+	long i, address;
+	int j;
+	bool is_success = TRUE;
+	line_ir *curr_line;
+	line.content = NULL; /* Source text isn't needed anymore - just the line number for errors */
+	line.length = 0;
+	for (i = 0; i < ir->count; i++) {
+		/* Too many errors - don't analyze the rest of the file */
+		if (OUT_OF_ERRORS(line.errors)) return FALSE;
+		curr_line = &ir->lines[i];
+		line.line_number = curr_line->line_number;
+		if (curr_line->kind == ENTRY_LINE) {
+			is_success &= process_entry_line(line, names, curr_line->operands[0].value, symbol_table);
+		} else if (curr_line->kind == CODE_LINE) {
+			/* Each operand takes a data word right after the code word */
+			for (j = 0, address = curr_line->address + 1; j < curr_line->operand_count; j++, address++) {
+				operand *curr_operand = &curr_line->operands[j];
+				if ((curr_operand->addressing == DIRECT_ADDR || curr_operand->addressing == RELATIVE_ADDR) &&
+				    !process_symbol_operand(line, curr_line->address, address, curr_operand->addressing,
+				                            curr_operand->value, memory_img, symbol_table, mem)) {
+					/* Stop processing the failed instruction - skip it's other operand, if there is one */
+					is_success = FALSE;
+					break;
 				}
-				add_table_item(symbol_table, token, entry->value, ENTRY_SYMBOL);
 			}
 		}
-		return TRUE;
 	}
-	return add_symbols_to_code(line, ic, memory_img, symbol_table);
+	return is_success;
 }
 
-/**
- * Find the symbol that need replacment in a code line, and replacing them by the address in the symbol table.
- * @param line The current code line that is being processed
- * @param ic A pointer to the current instruction counter
- * @param memory_img The machine code image array
- * @param data_table The data symbol table
- * @param code_table The code symbol table
- * @param ext_table The externals symbol table
- * @param ext_references A pointer to the external symbols references table
- * @return whether succeeded
- */
-bool add_symbols_to_code(line_info line, long *ic, machine_word **memory_img, table *symbol_table) {
-	char temp[80];
-	char *operands[2];
-	int i = 0, operand_count;
-	bool isvalid = TRUE;
-	long curr_ic = *ic; /* using curr_ic as temp index inside the code image, in the current line code+data words */
-	/* Get the total word length of current code text line in code binary image */
-	int length = memory_img[(*ic) - IC_INIT_VALUE]->length;
-	/* if the length is 1, then there's only the code word, no data. */
-	if (length > 1) {
-		/* Now, we need to skip command, and get the operands themselves: */
-		MOVE_TO_NOT_WHITE(line.content, i)
-		find_label(line, temp);
-		if (temp[0] != '\0') { /* if symbol is defined */
-			/* move i right after it's end */
-			for (; line.content[i] && line.content[i] != '\n' && line.content[i] != EOF && line.content[i] != ' ' &&
-			       line.content[i] != '\t'; i++);
-			i++;
-		}
-		MOVE_TO_NOT_WHITE(line.content, i)
-		/* now skip command */
-		for (; line.content[i] && line.content[i] != ' ' && line.content[i] != '\t' && line.content[i] != '\n' &&
-		       line.content[i] != EOF; i++);
-		MOVE_TO_NOT_WHITE(line.content, i)
-		/* now analyze operands We send NULL as string of command because no error will be printed, and that's the only usage for it there. */
-		analyze_operands(line, i, operands, &operand_count, NULL);
-		/* Process operands, if needed. if failed return failure. otherwise continue */
-		if (operand_count--) {
-			curr_ic++;
-			isvalid = process_spass_operand(line, &curr_ic, ic, operands[0], memory_img, symbol_table);
-			free(operands[0]);
-			if (!isvalid) return FALSE;
-			if (operand_count) {
-				curr_ic++;
-				isvalid = process_spass_operand(line, &curr_ic, ic, operands[1], memory_img, symbol_table);
-				free(operands[1]);
-				if (!isvalid) return FALSE;
-			}
+static bool process_entry_line(line_info line, name_table *names, long name, table *symbol_table) {
+	table_entry *entry;
+	char *symbol = name_by_id(names, name);
+	if (symbol[0] == '\0') {
+		printf_line_error(line, "You have to specify a label name for .entry instruction.");
+		return FALSE;
+	}
+	/* if label is already marked as entry, ignore. */
+	if (find_by_types(*symbol_table, name, SYMBOL_MASK(ENTRY_SYMBOL)) != NULL) return TRUE;
+	if (symbol[0] == '&') name = find_name(names, ++symbol);
+	/* if symbol is not defined as data/code */
+	if ((entry = find_by_types(*symbol_table, name, SYMBOL_MASK(DATA_SYMBOL) | SYMBOL_MASK(CODE_SYMBOL))) == NULL) {
+		/* if defined as external print error */
+		if ((entry = find_by_types(*symbol_table, name, SYMBOL_MASK(EXTERNAL_SYMBOL))) != NULL) {
+			printf_line_error(line, "The symbol %s can be either external or entry, but not both.", entry->key);
+			return FALSE;
 		}
+		/* otherwise print more general error */
+		printf_line_error(line, "The symbol %s for .entry is undefined.", symbol);
+		return FALSE;
 	}
-	/* Make the current pass IC as the next line ic */
-	(*ic) = (*ic) + length;
+	add_table_item(symbol_table, name, entry->value, ENTRY_SYMBOL);
 	return TRUE;
 }
 
-/**
- * Builds the additional data word for operand in the second pass, if needed.
- * @param curr_ic Current instruction pointer of source code line
- * @param ic Current instruction pointer of source code line start
- * @param operand The operand string
- * @param memory_img The code image array
- * @param symbol_table The symbol table
- * @return Whether succeeded
- */
-int process_spass_operand(line_info line, long *curr_ic, long *ic, char *operand, machine_word **memory_img,
-                          table *symbol_table) {
-	addressing_type addr = get_addressing_type(operand);
+static bool process_symbol_operand(line_info line, long instruction_address, long address, addressing_type addressing,
+                                   long name, machine_word **memory_img, table *symbol_table, arena *mem) {
+	long data_to_add;
 	machine_word *word_to_write;
-	/* if the word on *IC has the immediately addressed value (done in first pass), go to next cell (increase ic) */
-	if (addr == IMMEDIATE_ADDR) (*curr_ic)++;
-	if (addr == RELATIVE_ADDR) operand++;
-	if (DIRECT_ADDR == addr || RELATIVE_ADDR == addr) {
-		short data_to_add;
-		table_entry *entry = find_by_types(*symbol_table, operand, 3, DATA_SYMBOL, CODE_SYMBOL, EXTERNAL_SYMBOL);
-		if (entry == NULL) {
-			printf_line_error(line, "The symbol %s not found", operand);
+	table_entry *entry = find_by_types(*symbol_table, name,
+	                                   SYMBOL_MASK(DATA_SYMBOL) | SYMBOL_MASK(CODE_SYMBOL) |
+	                                   SYMBOL_MASK(EXTERNAL_SYMBOL));
+	if (entry == NULL) {
+		printf_line_error(line, "The symbol %s not found", name_by_id((*symbol_table)->names, name));
+		return FALSE;
+	}
+	/*found symbol*/
+	data_to_add = entry->value;
+	/* Calculate the distance to the label from the instruction if needed */
+	if (addressing == RELATIVE_ADDR) {
+		/* if not code symbol it's impossible to calculate distance! */
+		if (entry->type != CODE_SYMBOL) {
+			printf_line_error(line, "The symbol %s cannot be addressed relatively because it's not a code symbol.",
+			                  entry->key);
 			return FALSE;
 		}
-		/*found symbol*/
-		data_to_add = entry->value;
-		/* Calculate the distance to the label from ic if needed */
-		if (addr == RELATIVE_ADDR) {
-			/* if not code symbol it's impossible to calculate distance! */
-			if (entry->type != CODE_SYMBOL) {
-				printf_line_error(line, "The symbol %s cannot be addressed relatively because it's not a code symbol.",
-				                  operand);
-				return FALSE;
-			}
-			data_to_add = data_to_add - *ic - 1;
-		}
-		/* Add to externals reference table if it's an external. increase ic because it's the next data word */
-		if (entry->type == EXTERNAL_SYMBOL) {
-			add_table_item(symbol_table, operand, (*curr_ic), EXTERNAL_REFERENCE);
-		}
-
-		/*found symbol*/
-		word_to_write = (machine_word *) calloc_with_check(sizeof(machine_word));
-		word_to_write->length = 0;
-		word_to_write->word.data = build_data_word(addr, data_to_add, entry->type == EXTERNAL_SYMBOL);
-		memory_img[(*curr_ic) - IC_INIT_VALUE] = word_to_write;
-
+		data_to_add = data_to_add - instruction_address - 1;
+	}
+	/* Add to externals reference table if it's an external */
+	if (entry->type == EXTERNAL_SYMBOL) {
+		add_table_item(symbol_table, name, address, EXTERNAL_REFERENCE);
 	}
+
+	word_to_write = (machine_word *) arena_alloc(mem, sizeof(machine_word));
+	word_to_write->length = 0;
+	word_to_write->word.data = build_data_word(addressing, data_to_add, entry->type == EXTERNAL_SYMBOL, mem);
+	memory_img[address - IC_INIT_VALUE] = word_to_write;
 	return TRUE;
 }
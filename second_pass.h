@@ -1,27 +1,24 @@
-/* Second pass line processing related functions */
+/* Second pass - resolves the symbols the first pass couldn't encode */
 #ifndef _SECOND_PASS_H
 #define _SECOND_PASS_H
 #include "globals.h"
 #include "table.h"
+#include "arena.h"
+#include "ir.h"
+#include "names.h"
 
 /**
- * Processes a single source line in the second pass
- * @param line The source line
- * @param ic A pointer to the current instruction counter
+ * Resolves all the symbol usages of a file, by the order of the source lines:
+ * fills the symbol-dependent data words, and adds the entries and the external references to the symbol table.
+ * @param ir The file's lines, from the first pass
+ * @param names The names table of the file
+ * @param line The file's source file name, error output and errors - the line number is set for each line
  * @param memory_img The code image
  * @param symbol_table The symbol table
+ * @param mem The arena to allocate the data words from
  * @return Whether succeeded
  */
-bool process_line_spass(line_info line, long *ic, machine_word **memory_img, table *symbol_table);
+bool resolve_symbols(ir_list *ir, name_table *names, line_info line, machine_word **memory_img, table *symbol_table,
+                     arena *mem);
 
-/**
- * Adds the symbol-dependent data words by the code line.
- * @param line The source code line
- * @param ic A pointer to the current instruction counter
- * @param memory_img The code image
- * @param symbol_table The symbol table
- * @return Whether succeeded
- */
-bool add_symbols_to_code(line_info line, long *ic, machine_word **memory_img, table *symbol_table);
-
-#endif
\ No newline at end of file
+#endif
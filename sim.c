@@ -0,0 +1,274 @@
+/* Implements the simulator. Each address of the code is decoded once, when loaded (or when the code is written),
+ * into an instruction that points right at it's operands - so running it is a single dispatch and a few moves. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "isa.h"
+#include "utils.h"
+
+/** The mask of a word's value */
+#define WORD_MASK 0xFFF
+
+/** The signed value of a 12-bit word */
+#define SIGNED_WORD(value) ((value) & 0x800 ? (int) (value) - 0x1000 : (int) (value))
+
+/** The value of red at the end of the input (-1) */
+#define END_OF_INPUT WORD_MASK
+
+machine *create_machine(FILE *input, FILE *output) {
+	long address;
+	machine *sim = calloc_with_check(sizeof(machine));
+	sim->input = input;
+	sim->output = output;
+	/* Nothing is code until loaded - running anywhere faults */
+	for (address = 0; address <= SIM_MEMORY_SIZE; address++) {
+		sim->code[address].operation = ISA_COUNT;
+		sim->code[address].length = 1;
+	}
+	return sim;
+}
+
+void free_machine(machine *sim) {
+	free(sim);
+}
+
+/**
+ * Decodes an operand of an instruction
+ * @param sim The machine
+ * @param curr The instruction
+ * @param word_address The address of the operand's word
+ * @param addressing The addressing of the operand
+ * @param slot 0 for the source, 1 for the destination
+ * @return The address the operand refers to (for direct and relative addressing), or -1 if the operand is invalid
+ */
+static long decode_operand(machine *sim, sim_instruction *curr, long word_address, int addressing, int slot) {
+	int reg, value = sim->memory[word_address];
+	int **operand = slot == 0 ? &curr->source : &curr->destination;
+	long address = 0;
+	switch (addressing) {
+		case IMMEDIATE_ADDR:
+			curr->immediate[slot] = value;
+			*operand = &curr->immediate[slot];
+			break;
+		case DIRECT_ADDR:
+			address = value;
+			*operand = &sim->memory[address];
+			break;
+		case RELATIVE_ADDR:
+			/* The distance is from the operand's word. A target out of the memory is a fault anyway */
+			address = word_address + SIGNED_WORD(value);
+			if (address < 0 || address >= SIM_MEMORY_SIZE) address = 0;
+			*operand = NULL;
+			break;
+		case REGISTER_ADDR:
+			/* The register word has a single bit on - the register's number */
+			for (reg = 0; reg < SIM_REGISTER_COUNT && value != 1 << reg; reg++);
+			if (reg == SIM_REGISTER_COUNT) return -1;
+			*operand = &sim->registers[reg];
+			break;
+	}
+	return address;
+}
+
+/**
+ * Decodes the instruction at an address of the code
+ * @param sim The machine
+ * @param address The address
+ */
+static void decode(machine *sim, long address) {
+	int i, word = sim->memory[address];
+	int source_addressing = (word >> 2) & 3, destination_addressing = word & 3;
+	long source_address = 0, destination_address = 0;
+	sim_instruction *curr = &sim->code[address];
+	isa_operation *operation;
+	curr->operation = ISA_COUNT;
+	curr->length = 1;
+	curr->source = curr->destination = NULL;
+	curr->writes_code = FALSE;
+
+	for (i = 0; i < ISA_COUNT && (isa_table[i].opcode != ((word >> 8) & 0xF) ||
+	                              isa_table[i].funct != ((word >> 4) & 0xF)); i++);
+	if (i == ISA_COUNT) return;
+	operation = &isa_table[i];
+	/* A single operand is the destination, and the addressing of a missing operand is 0. The operands are code too */
+	if ((operation->operand_count < 2 && source_addressing != 0) ||
+	    (operation->operand_count < 1 && destination_addressing != 0) ||
+	    (operation->operand_count == 2 && !IS_MODE_ALLOWED(operation->source_modes, source_addressing)) ||
+	    (operation->operand_count >= 1 && !IS_MODE_ALLOWED(operation->destination_modes, destination_addressing)) ||
+	    address + operation->operand_count >= sim->code_end) {
+		return;
+	}
+	if (operation->operand_count == 2) {
+		source_address = decode_operand(sim, curr, address + 1, source_addressing, 0);
+	}
+	if (operation->operand_count >= 1) {
+		destination_address = decode_operand(sim, curr, address + operation->operand_count, destination_addressing, 1);
+	}
+	if (source_address < 0 || destination_address < 0) return;
+
+	curr->operation = i;
+	curr->length = 1 + operation->operand_count;
+	/* lea loads the address of it's source, and the jumps go to the address of their destination */
+	curr->address = (int) (i == LEA_ISA ? source_address : destination_address);
+	curr->writes_code = destination_addressing == DIRECT_ADDR && i != CMP_ISA && i != PRN_ISA && i != JMP_ISA &&
+	                    i != BNE_ISA && i != JSR_ISA && destination_address >= IC_INIT_VALUE &&
+	                    destination_address < sim->code_end;
+}
+
+/**
+ * Decodes again all the instructions that have a word that was just written
+ * @param sim The machine
+ * @param address The address of the word
+ */
+static void decode_written(machine *sim, long address) {
+	long first = address - 2 < IC_INIT_VALUE ? IC_INIT_VALUE : address - 2;
+	for (; first <= address; first++) decode(sim, first);
+}
+
+bool load_machine(machine *sim, object_module *module, FILE *output) {
+	long i, word_count = module->code_length + module->data_length;
+	if (module->external_count > 0) {
+		fprintf(output, "Error: The image refers to external symbols (%s first). Link it first.\n",
+		        module->externals[0].name);
+		return FALSE;
+	}
+	if (IC_INIT_VALUE + word_count > SIM_MEMORY_SIZE) {
+		fprintf(output, "Error: The image (%ld words) doesn't fit in the memory.\n", word_count);
+		return FALSE;
+	}
+	for (i = 0; i < word_count; i++) sim->memory[IC_INIT_VALUE + i] = (int) (module->words[i] & WORD_MASK);
+	sim->code_end = IC_INIT_VALUE + module->code_length;
+	for (i = IC_INIT_VALUE; i < sim->code_end; i++) decode(sim, i);
+	return TRUE;
+}
+
+void flush_machine(machine *sim) {
+	fwrite(sim->output_buffer, 1, sim->output_size, sim->output);
+	fflush(sim->output);
+	sim->output_size = 0;
+}
+
+/**
+ * Reads a single char of the input, for red
+ * @param sim The machine
+ * @return The char, or END_OF_INPUT
+ */
+static int read_char(machine *sim) {
+	if (sim->input_used == sim->input_size) {
+		/* The program may have prompted for the input */
+		flush_machine(sim);
+		sim->input_size = fread(sim->input_buffer, 1, SIM_IO_BUFFER_SIZE, sim->input);
+		sim->input_used = 0;
+		if (sim->input_size == 0) return END_OF_INPUT;
+	}
+	return sim->input_buffer[sim->input_used++];
+}
+
+/**
+ * Writes a single char to the output, for prn
+ * @param sim The machine
+ * @param value The value to print, as a char
+ */
+static void write_char(machine *sim, int value) {
+	if (sim->output_size == SIM_IO_BUFFER_SIZE) flush_machine(sim);
+	sim->output_buffer[sim->output_size++] = (char) value;
+}
+
+sim_status run_machine(machine *sim, unsigned long max_instructions) {
+	long pc = IC_INIT_VALUE, next;
+	unsigned long count = 0, cycles = 0, limit = max_instructions == 0 ? (unsigned long) -1 : max_instructions;
+	bool zero = FALSE;
+	sim_status status = SIM_STOPPED;
+	sim_instruction *curr;
+	int *destination;
+	char *fault = NULL; /* Set when the machine stops - kept out of the machine, so the loop doesn't reload it */
+	sim->stack_depth = 0;
+
+	while (fault == NULL) {
+		if (count == limit) {
+			status = SIM_LIMIT_REACHED;
+			break;
+		}
+		curr = &sim->code[pc];
+		destination = curr->destination;
+		next = pc + curr->length;
+		count++;
+		cycles += curr->length;
+		switch (curr->operation) {
+			case MOV_ISA:
+				*destination = *curr->source;
+				break;
+			case CMP_ISA:
+				zero = *curr->source == *destination;
+				break;
+			case ADD_ISA:
+				*destination = (*destination + *curr->source) & WORD_MASK;
+				break;
+			case SUB_ISA:
+				*destination = (*destination - *curr->source) & WORD_MASK;
+				break;
+			case LEA_ISA:
+				*destination = curr->address;
+				break;
+			case CLR_ISA:
+				*destination = 0;
+				break;
+			case NOT_ISA:
+				*destination = ~*destination & WORD_MASK;
+				break;
+			case INC_ISA:
+				*destination = (*destination + 1) & WORD_MASK;
+				break;
+			case DEC_ISA:
+				*destination = (*destination - 1) & WORD_MASK;
+				break;
+			case JMP_ISA:
+				next = curr->address;
+				break;
+			case BNE_ISA:
+				if (!zero) next = curr->address;
+				break;
+			case JSR_ISA:
+				if (sim->stack_depth == SIM_STACK_SIZE) fault = "Call stack overflow";
+				else {
+					sim->stack[sim->stack_depth++] = next;
+					next = curr->address;
+				}
+				break;
+			case RED_ISA:
+				*destination = read_char(sim) & WORD_MASK;
+				break;
+			case PRN_ISA:
+				write_char(sim, *destination);
+				break;
+			case RTS_ISA:
+				if (sim->stack_depth == 0) fault = "Return without a call";
+				else next = sim->stack[--sim->stack_depth];
+				break;
+			case STOP_ISA:
+				fault = ""; /* Not a fault - just leave the loop */
+				break;
+			default:
+				fault = pc >= IC_INIT_VALUE && pc < sim->code_end ? "Invalid instruction" : "Ran out of the code";
+				break;
+		}
+		if (curr->writes_code) decode_written(sim, destination - sim->memory);
+		if (fault == NULL) pc = next;
+	}
+
+	if (fault != NULL && *fault == '\0') fault = NULL;
+	else if (fault != NULL) {
+		status = SIM_FAULT;
+		/* The faulting instruction didn't run */
+		count--;
+		cycles -= curr->length;
+	}
+	sim->fault = fault;
+	sim->pc = pc;
+	sim->zero = zero;
+	sim->instructions += count;
+	sim->cycles += cycles;
+	flush_machine(sim);
+	return status;
+}
@@ -0,0 +1,113 @@
+/* Implements a simulator of the machine, which runs an assembled (and linked) image */
+#ifndef _SIM_H
+#define _SIM_H
+#include <stdio.h>
+#include "globals.h"
+#include "object.h"
+
+/** Count of words of the memory - every 12-bit address */
+#define SIM_MEMORY_SIZE 4096
+
+/** Count of registers (r0-r7) */
+#define SIM_REGISTER_COUNT 8
+
+/** Maximum depth of subroutine calls (jsr) */
+#define SIM_STACK_SIZE 1024
+
+/** Size of the buffers of red and prn */
+#define SIM_IO_BUFFER_SIZE 4096
+
+/** Why the machine stopped running */
+typedef enum sim_status {
+	/** Ran the stop operation */
+	SIM_STOPPED,
+	/** Ran the maximum count of instructions it was given */
+	SIM_LIMIT_REACHED,
+	/** An invalid instruction, or a jump out of the code, or a call stack overflow/underflow */
+	SIM_FAULT
+} sim_status;
+
+/** A single instruction, decoded - one is decoded for each address of the code */
+typedef struct sim_instruction {
+	/** The operation (an isa_index), or ISA_COUNT if the word isn't a valid instruction */
+	int operation;
+	/** Count of words of the instruction */
+	int length;
+	/** Where the operands are read from & written to: a register, a memory word, or the immediate value below */
+	int *source;
+	int *destination;
+	/** The immediate value of the source (or of the destination, for cmp and prn) */
+	int immediate[2];
+	/** The address of the source operand (for lea), or the target of a jump */
+	int address;
+	/** Whether the destination is a word of the code, so writing it changes the instructions */
+	bool writes_code;
+} sim_instruction;
+
+/** The whole machine */
+typedef struct machine {
+	/** The memory, a 12-bit value in each word */
+	int memory[SIM_MEMORY_SIZE];
+	/** The decoded instruction at each address (and right after the memory's end, where nothing is code) */
+	sim_instruction code[SIM_MEMORY_SIZE + 1];
+	/** The address right after the code */
+	long code_end;
+	int registers[SIM_REGISTER_COUNT];
+	/** The program counter, and the zero flag of the last cmp */
+	long pc;
+	bool zero;
+	/** The return addresses of the subroutine calls */
+	long stack[SIM_STACK_SIZE];
+	int stack_depth;
+	/** Count of instructions run, and of cycles - each word of an instruction takes a single cycle to fetch */
+	unsigned long instructions;
+	unsigned long cycles;
+	/** The streams of red and prn, and their buffers */
+	FILE *input;
+	FILE *output;
+	unsigned char input_buffer[SIM_IO_BUFFER_SIZE];
+	long input_used, input_size;
+	char output_buffer[SIM_IO_BUFFER_SIZE];
+	long output_size;
+	/** Why the machine faulted, if it did */
+	char *fault;
+} machine;
+
+/**
+ * Creates a new machine, with an empty memory
+ * @param input The stream which red reads from
+ * @param output The stream which prn writes to
+ * @return The new machine
+ */
+machine *create_machine(FILE *input, FILE *output);
+
+/**
+ * Deallocates a machine
+ * @param sim The machine
+ */
+void free_machine(machine *sim);
+
+/**
+ * Loads a linked image into the machine's memory, from IC_INIT_VALUE, and decodes it's code
+ * @param sim The machine
+ * @param module The image. It must not refer to external symbols
+ * @param output The stream to print the errors to
+ * @return Whether succeeded
+ */
+bool load_machine(machine *sim, object_module *module, FILE *output);
+
+/**
+ * Runs the machine from the start of the code, until it stops
+ * @param sim The machine, loaded
+ * @param max_instructions The maximum count of instructions to run (0 for unlimited)
+ * @return Why the machine stopped running
+ */
+sim_status run_machine(machine *sim, unsigned long max_instructions);
+
+/**
+ * Writes the buffered output of prn to the output stream
+ * @param sim The machine
+ */
+void flush_machine(machine *sim);
+
+#endif
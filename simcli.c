@@ -0,0 +1,51 @@
+/* Runs an assembled and linked image on the simulator */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "sim.h"
+#include "object.h"
+#include "arena.h"
+#include "utils.h"
+
+/**
+ * Entry point - runs the image in the arguments. red reads stdin, and prn writes stdout.
+ */
+int main(int argc, char *argv[]) {
+	int i;
+	char *image_name = NULL, *end;
+	unsigned long max_instructions = 0;
+	bool verbose = FALSE, is_success;
+	sim_status status = SIM_FAULT;
+	object_module module;
+	machine *sim;
+	arena mem;
+
+	/* Collect the image, the maximum count of instructions (-n N), and whether to print the counters (-v) */
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-v") == 0) {
+			verbose = TRUE;
+		} else if (strcmp(argv[i], "-n") == 0) {
+			if (++i == argc || (max_instructions = strtoul(argv[i], &end, 10), *end != '\0')) {
+				fprintf(stderr, "Error: -n expects a count of instructions.\n");
+				return 1;
+			}
+		} else image_name = argv[i];
+	}
+	if (image_name == NULL) {
+		fprintf(stderr, "Usage: %s [-v] [-n max_instructions] image\n", argv[0]);
+		return 1;
+	}
+
+	arena_init(&mem);
+	sim = create_machine(stdin, stdout);
+	is_success = read_object(image_name, &module, &mem, stderr) && load_machine(sim, &module, stderr);
+	if (is_success) {
+		status = run_machine(sim, max_instructions);
+		if (status == SIM_FAULT) fprintf(stderr, "Error: %s at %.4ld.\n", sim->fault, sim->pc);
+		else if (status == SIM_LIMIT_REACHED) fprintf(stderr, "Stopped after %lu instructions.\n", max_instructions);
+		if (verbose) fprintf(stderr, "Instructions: %lu, cycles: %lu\n", sim->instructions, sim->cycles);
+	}
+	free_machine(sim);
+	arena_free(&mem);
+	return is_success && status == SIM_STOPPED ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+/* Implements the source reader: a single bulk read of the file, and an index of it's lines */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "source.h"
+#include "scan.h"
+#include "utils.h"
+
+/** Size of the first read, the buffer doubles from it as needed */
+#define INITIAL_SOURCE_SIZE 4096L
+
+bool read_whole_file(FILE *file, char **data, long *size) {
+	long capacity = INITIAL_SOURCE_SIZE;
+	size_t read_count;
+	char *text;
+	/* Room for the terminator, and a block of zeros to scan past the last line */
+	*size = 0;
+	if ((*data = calloc(1, capacity + SCAN_BLOCK_SIZE)) == NULL) return FALSE;
+	/* Read in chunks big as what was read so far, so works for pipes as well as regular files */
+	while ((read_count = fread(*data + *size, 1, capacity - *size, file)) > 0) {
+		*size += read_count;
+		if (*size == capacity) {
+			if (capacity > (LONG_MAX - SCAN_BLOCK_SIZE) / 2 ||
+			    (text = realloc(*data, capacity * 2 + SCAN_BLOCK_SIZE)) == NULL) {
+				return FALSE;
+			}
+			*data = text;
+			capacity *= 2;
+		}
+	}
+	memset(*data + *size, 0, SCAN_BLOCK_SIZE);
+	return !ferror(file);
+}
+
+/**
+ * Indexes the lines of the source's text, and terminates each of them in place
+ * @param source The source
+ * @return Whether succeeded (false if out of memory)
+ */
+static bool index_lines(source_file *source) {
+	char *curr, *end = source->text + source->size;
+	long line_count = 0;
+	/* Count the line breaks first, so the index is allocated once */
+	for (curr = source->text; (curr = memchr(curr, '\n', end - curr)) != NULL; curr++) {
+		line_count++;
+	}
+	/* The last line might not end with '\n' */
+	if (source->size > 0 && end[-1] != '\n') line_count++;
+	source->line_count = line_count;
+	if ((source->line_offsets = calloc(line_count + 1, sizeof(long))) == NULL) return FALSE;
+
+	line_count = 0;
+	for (curr = source->text; curr < end; curr++) {
+		source->line_offsets[line_count++] = curr - source->text;
+		if ((curr = memchr(curr, '\n', end - curr)) == NULL) curr = end;
+		*curr = '\0';
+	}
+	/* So the length of the last line is found like any other's */
+	source->line_offsets[line_count] = curr - source->text;
+	return TRUE;
+}
+
+bool read_source(source_file *source, FILE *file) {
+	source->line_offsets = NULL;
+	source->line_count = 0;
+	return read_whole_file(file, &source->text, &source->size) && index_lines(source);
+}
+
+bool copy_source(source_file *source, const char *text, long size) {
+	source->line_offsets = NULL;
+	source->line_count = 0;
+	source->size = size;
+	if ((source->text = calloc(1, size + SCAN_BLOCK_SIZE)) == NULL) return FALSE;
+	memcpy(source->text, text, size);
+	return index_lines(source);
+}
+
+char *source_line(source_file *source, long index) {
+	return source->text + source->line_offsets[index];
+}
+
+long source_line_length(source_file *source, long index) {
+	return source->line_offsets[index + 1] - source->line_offsets[index] - 1;
+}
+
+void free_source(source_file *source) {
+	free(source->text);
+	free(source->line_offsets);
+	source->text = NULL;
+	source->line_offsets = NULL;
+}
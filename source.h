@@ -0,0 +1,69 @@
+/* Reads a whole source file at once, and indexes it's lines */
+#ifndef _SOURCE_H
+#define _SOURCE_H
+#include <stdio.h>
+#include "globals.h"
+
+/** A source file, read into memory */
+typedef struct source_file {
+	/** The whole text of the file. Each line break is replaced by '\0', so each line is a string in place.
+	 * It's padded by zeros, so the lines can be scanned in whole blocks */
+	char *text;
+	/** Size of the text, in bytes */
+	long size;
+	/** Offset of each line in the text, and (at line_count) the offset right after the last line's end */
+	long *line_offsets;
+	/** Count of lines */
+	long line_count;
+} source_file;
+
+/**
+ * Reads the rest of a file into memory, as is
+ * @param file The file to read
+ * @param data Where to return the content, NUL-terminated and padded by zeros (a scanner's block, SCAN_BLOCK_SIZE).
+ *             Must be deallocated even if failed
+ * @param size Where to return the size of the content, in bytes
+ * @return Whether succeeded
+ */
+bool read_whole_file(FILE *file, char **data, long *size);
+
+/**
+ * Reads the rest of a file into memory, and indexes it's lines
+ * @param source The source to read into
+ * @param file The file to read
+ * @return Whether succeeded
+ */
+bool read_source(source_file *source, FILE *file);
+
+/**
+ * Copies a text that is already in memory into a source, and indexes it's lines
+ * @param source The source to copy into. Must be deallocated even if failed
+ * @param text The text
+ * @param size Size of the text, in bytes
+ * @return Whether succeeded (false if out of memory)
+ */
+bool copy_source(source_file *source, const char *text, long size);
+
+/**
+ * Returns a line of the source
+ * @param source The source
+ * @param index The index of the line (starting from 0)
+ * @return The line's content, NUL-terminated (without the line break)
+ */
+char *source_line(source_file *source, long index);
+
+/**
+ * Returns the length of a line of the source
+ * @param source The source
+ * @param index The index of the line (starting from 0)
+ * @return The length of the line's content, without the line break
+ */
+long source_line_length(source_file *source, long index);
+
+/**
+ * Deallocates the text and the index of the source
+ * @param source The source
+ */
+void free_source(source_file *source);
+
+#endif
@@ -0,0 +1,218 @@
+/* Implements the statistics of assembling. The counters of the hot paths are kept by the structures themselves
+ * (the symbol table and the arena), so measuring a file only reads them - the cost when not measuring is an increment. */
+/* clock_gettime & syscall, for the clocks and the hardware counters */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+#include "stats.h"
+#include "writefiles.h"
+#include "utils.h"
+#include "version.h"
+
+/** The names of the phases and of the hardware counters, as written to the stats file */
+static char *phase_names[PHASE_COUNT] = {"read", "first_pass", "second_pass", "write"};
+static char *counter_names[COUNTER_COUNT] = {"cycles", "instructions", "cache_misses"};
+
+double stats_wall_clock(void) {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * Returns the CPU time of the calling thread
+ * @return The time, in seconds
+ */
+static double cpu_clock(void) {
+	struct timespec time;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+/**
+ * Opens and starts a hardware counter of the calling thread (user space only)
+ * @param counter The counter
+ * @return It's descriptor, or -1 if unavailable
+ */
+static int open_counter(stats_counter counter) {
+#ifdef __linux__
+	static unsigned long configs[COUNTER_COUNT] = {
+			PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES
+	};
+	int fd;
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = configs[counter];
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	fd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+	if (fd >= 0) {
+		ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+	return fd;
+#else
+	return -1;
+#endif
+}
+
+/**
+ * Stops and closes a hardware counter
+ * @param fd It's descriptor, or -1 if unavailable
+ * @return It's value, or -1 if unavailable
+ */
+static double close_counter(int fd) {
+#ifdef __linux__
+	__u64 value;
+	bool is_read;
+	if (fd < 0) return -1;
+	ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+	is_read = read(fd, &value, sizeof(value)) == sizeof(value);
+	close(fd);
+	return is_read ? (double) value : -1;
+#else
+	return -1;
+#endif
+}
+
+void start_file_stats(file_stats *stats, char *filename) {
+	int i;
+	if (stats == NULL) return;
+	memset(stats, 0, sizeof(file_stats));
+	stats->filename = filename;
+	for (i = 0; i < COUNTER_COUNT; i++) stats->counter_fds[i] = open_counter(i);
+	stats->phase_wall_start = stats_wall_clock();
+	stats->phase_cpu_start = cpu_clock();
+}
+
+void end_phase(file_stats *stats, stats_phase phase) {
+	double wall_now, cpu_now;
+	if (stats == NULL) return;
+	wall_now = stats_wall_clock();
+	cpu_now = cpu_clock();
+	stats->wall_time[phase] += wall_now - stats->phase_wall_start;
+	stats->cpu_time[phase] += cpu_now - stats->phase_cpu_start;
+	stats->phase_wall_start = wall_now;
+	stats->phase_cpu_start = cpu_now;
+}
+
+void stop_file_stats(file_stats *stats, bool succeeded) {
+	int i;
+	if (stats == NULL) return;
+	stats->succeeded = succeeded;
+	for (i = 0; i < COUNTER_COUNT; i++) {
+		stats->counters[i] = close_counter(stats->counter_fds[i]);
+		stats->counter_fds[i] = -1;
+	}
+}
+
+void count_output_bytes(file_stats *stats, char *filename, bool binary) {
+	int i;
+	char *path;
+	struct stat status;
+	if (stats == NULL) return;
+	stats->output_bytes = 0;
+	/* The sizes of the output files */
+	for (i = 0; i < OUTPUT_COUNT(binary); i++) {
+		path = strallocat(filename, output_extensions[i]);
+		if (stat(path, &status) == 0) stats->output_bytes += status.st_size;
+		free(path);
+	}
+}
+
+/**
+ * Writes a string as a JSON string, quoted and escaped
+ * @param file_desc The file to write to
+ * @param str The string
+ */
+static void write_json_string(FILE *file_desc, char *str) {
+	unsigned char *curr;
+	fputc('"', file_desc);
+	for (curr = (unsigned char *) str; *curr != '\0'; curr++) {
+		if (*curr == '"' || *curr == '\\') fprintf(file_desc, "\\%c", *curr);
+		else if (*curr < ' ') fprintf(file_desc, "\\u%04x", *curr);
+		else fputc(*curr, file_desc);
+	}
+	fputc('"', file_desc);
+}
+
+/**
+ * Writes the measurements of a file (or of all of them), as the fields of a JSON object
+ * @param file_desc The file to write to
+ * @param stats The statistics
+ */
+static void write_measurements(FILE *file_desc, file_stats *stats) {
+	int i;
+	fprintf(file_desc, "\"lines\": %ld, \"words\": %ld, \"symbol_lookups\": %ld, \"symbol_probes\": %ld, "
+	                   "\"allocations\": %ld, \"allocated_bytes\": %ld, \"output_bytes\": %ld, ",
+	        stats->lines, stats->words, stats->symbol_lookups, stats->symbol_probes, stats->allocations,
+	        stats->allocated_bytes, stats->output_bytes);
+	fputs("\"phases\": {", file_desc);
+	for (i = 0; i < PHASE_COUNT; i++) {
+		fprintf(file_desc, "%s\"%s\": {\"wall\": %.6f, \"cpu\": %.6f}", i > 0 ? ", " : "", phase_names[i],
+		        stats->wall_time[i], stats->cpu_time[i]);
+	}
+	fputs("}", file_desc);
+	/* Unavailable hardware counters are null */
+	for (i = 0; i < COUNTER_COUNT; i++) {
+		if (stats->counters[i] < 0) fprintf(file_desc, ", \"%s\": null", counter_names[i]);
+		else fprintf(file_desc, ", \"%s\": %.0f", counter_names[i], stats->counters[i]);
+	}
+}
+
+bool write_stats(char *stats_filename, file_stats *stats, long count, int workers, double wall_time) {
+	int i;
+	long j, succeeded = 0;
+	bool is_success;
+	file_stats total;
+	FILE *file_desc = fopen(stats_filename, "w");
+	if (file_desc == NULL) return FALSE;
+
+	memset(&total, 0, sizeof(file_stats));
+	fprintf(file_desc, "{\n\"version\": \"%s\",\n\"workers\": %d,\n\"wall_time\": %.6f,\n\"files\": [",
+	        ASSEMBLER_VERSION, workers, wall_time);
+	for (j = 0; j < count; j++) {
+		fputs(j > 0 ? ",\n\t{\"file\": " : "\n\t{\"file\": ", file_desc);
+		write_json_string(file_desc, stats[j].filename);
+		fprintf(file_desc, ", \"succeeded\": %s, ", stats[j].succeeded ? "true" : "false");
+		write_measurements(file_desc, &stats[j]);
+		fputs("}", file_desc);
+
+		/* The total of each measurement - a hardware counter is only summed if every file has it */
+		if (stats[j].succeeded) succeeded++;
+		total.lines += stats[j].lines;
+		total.words += stats[j].words;
+		total.symbol_lookups += stats[j].symbol_lookups;
+		total.symbol_probes += stats[j].symbol_probes;
+		total.allocations += stats[j].allocations;
+		total.allocated_bytes += stats[j].allocated_bytes;
+		total.output_bytes += stats[j].output_bytes;
+		for (i = 0; i < PHASE_COUNT; i++) {
+			total.wall_time[i] += stats[j].wall_time[i];
+			total.cpu_time[i] += stats[j].cpu_time[i];
+		}
+		for (i = 0; i < COUNTER_COUNT; i++) {
+			total.counters[i] = total.counters[i] < 0 || stats[j].counters[i] < 0 ? -1 :
+			                    total.counters[i] + stats[j].counters[i];
+		}
+	}
+	fprintf(file_desc, "\n],\n\"total\": {\"files\": %ld, \"succeeded\": %ld, ", count, succeeded);
+	write_measurements(file_desc, &total);
+	fputs("}\n}\n", file_desc);
+
+	is_success = !ferror(file_desc);
+	is_success = fclose(file_desc) == 0 && is_success;
+	return is_success;
+}
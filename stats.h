@@ -0,0 +1,100 @@
+/* Implements the statistics of assembling (--stats): the time of each phase, and counters of the hot paths */
+#ifndef _STATS_H
+#define _STATS_H
+#include <stdio.h>
+#include "globals.h"
+
+/** A phase of processing a file */
+typedef enum stats_phase {
+	/** Reading the source (and looking it up in the cache) */
+	READ_PHASE,
+	FIRST_PASS_PHASE,
+	/** Resolving the symbols */
+	SECOND_PASS_PHASE,
+	/** Writing the output files (and caching them) */
+	WRITE_PHASE,
+	PHASE_COUNT
+} stats_phase;
+
+/** The hardware counters, where the system lets us read them */
+typedef enum stats_counter {
+	CYCLES_COUNTER,
+	INSTRUCTIONS_COUNTER,
+	CACHE_MISSES_COUNTER,
+	COUNTER_COUNT
+} stats_counter;
+
+/** The statistics of a single file */
+typedef struct file_stats {
+	/** The file name, as given in the arguments */
+	char *filename;
+	bool succeeded;
+	/** Wall and CPU (of the file's thread) time of each phase, in seconds */
+	double wall_time[PHASE_COUNT];
+	double cpu_time[PHASE_COUNT];
+	/** When the current phase started */
+	double phase_wall_start;
+	double phase_cpu_start;
+	/** Count of lines of the source, and of words of the code & data */
+	long lines;
+	long words;
+	/** Count of symbol lookups, and of the table entries they went over */
+	long symbol_lookups;
+	long symbol_probes;
+	/** Count of allocations from the file's arena, and of their bytes */
+	long allocations;
+	long allocated_bytes;
+	/** Size of the output files */
+	long output_bytes;
+	/** The hardware counters: their descriptors while counting (-1 if unavailable), and their values */
+	int counter_fds[COUNTER_COUNT];
+	double counters[COUNTER_COUNT];
+} file_stats;
+
+/**
+ * Returns the time of a monotonic clock
+ * @return The time, in seconds
+ */
+double stats_wall_clock(void);
+
+/**
+ * Starts measuring a file: clears it's statistics, starts the hardware counters and the first phase
+ * @param stats The file's statistics, or NULL if not measured
+ * @param filename The file name, as given in the arguments
+ */
+void start_file_stats(file_stats *stats, char *filename);
+
+/**
+ * Ends a phase, adding the time since the previous one ended to it
+ * @param stats The file's statistics, or NULL if not measured
+ * @param phase The phase
+ */
+void end_phase(file_stats *stats, stats_phase phase);
+
+/**
+ * Stops measuring a file, and reads the hardware counters
+ * @param stats The file's statistics, or NULL if not measured
+ * @param succeeded Whether the file was assembled
+ */
+void stop_file_stats(file_stats *stats, bool succeeded);
+
+/**
+ * Sets the size of the output files of a file
+ * @param stats The file's statistics, or NULL if not measured
+ * @param filename The filename of the outputs, without the extension
+ * @param binary Whether the binary object was written as well
+ */
+void count_output_bytes(file_stats *stats, char *filename, bool binary);
+
+/**
+ * Writes the statistics of a run, as JSON
+ * @param stats_filename The file to write to
+ * @param stats The statistics of each file
+ * @param count The count of files
+ * @param workers The count of workers
+ * @param wall_time The wall time of the whole run, in seconds
+ * @return Whether succeeded
+ */
+bool write_stats(char *stats_filename, file_stats *stats, long count, int workers, double wall_time);
+
+#endif
@@ -1,97 +1,126 @@
-/* Implements a basic table ("dictionary") data structure. sorted by value, ascending. */
+/* Implements a basic table ("dictionary") data structure, indexed by the name ids of the keys. */
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
-#include <stdarg.h>
 #include "table.h"
 #include "utils.h"
 
-void add_table_item(table *tab, char *key, long value, symbol_type type) {
-	char *temp_key;
-	table prev_entry, curr_entry, new_entry;
+/** Initial count of cells in the index by name id */
+#define INITIAL_INDEX_COUNT 64
+
+/** External references are never looked up by name (and there may be many of the same name), so they aren't indexed */
+#define IS_INDEXED(type) ((type) != EXTERNAL_REFERENCE)
+
+/**
+ * Grows the index by name id (doubling it's size), until it has a cell for the name id
+ * @param tab The table
+ * @param name The name id
+ */
+static void grow_index(table tab, long name) {
+	long new_count = tab->by_name_count * 2;
+	table_entry **new_index;
+	while (new_count <= name) new_count *= 2;
+	new_index = arena_alloc(tab->mem, new_count * sizeof(table_entry *));
+	memcpy(new_index, tab->by_name, tab->by_name_count * sizeof(table_entry *));
+	tab->by_name = new_index;
+	tab->by_name_count = new_count;
+}
+
+table create_table(name_table *names) {
+	table tab = arena_alloc(names->mem, sizeof(struct symbol_table));
+	tab->names = names;
+	tab->mem = names->mem;
+	tab->by_name_count = INITIAL_INDEX_COUNT;
+	tab->by_name = arena_alloc(tab->mem, INITIAL_INDEX_COUNT * sizeof(table_entry *));
+	return tab;
+}
+
+void add_table_item(table *tab, long name, long value, symbol_type type) {
+	table_entry *new_entry;
 	/* allocate memory for new entry */
-	new_entry = (table) calloc_with_check(sizeof(table_entry));
-	/* Prevent "Aliasing" of pointers. Don't worry-when we free the list, we also free these allocated char ptrs */
-	temp_key = (char *) calloc_with_check(strlen(key) + 1);
-	strcpy(temp_key, key);
-	new_entry->key = temp_key;
+	new_entry = (table_entry *) arena_alloc((*tab)->mem, sizeof(table_entry));
+	/* The name is stored once, in the names table */
+	new_entry->name = name;
+	new_entry->key = name_by_id((*tab)->names, name);
 	new_entry->value = value;
 	new_entry->type = type;
-	/* if the table's null, set the new entry as the head. */
-	if ((*tab) == NULL || (*tab)->value > value) {
-		new_entry->next = (*tab);
-		(*tab) = new_entry;
-		return;
-	}
 
-	/* Insert the new table entry, keeping it sorted */
-	curr_entry = (*tab)->next;
-	prev_entry = *tab;
-	while (curr_entry != NULL && curr_entry->value < value) {
-		prev_entry = curr_entry;
-		curr_entry = curr_entry->next;
+	/* Push to the list of the name */
+	if (IS_INDEXED(type)) {
+		if (name >= (*tab)->by_name_count) grow_index(*tab, name);
+		new_entry->name_next = (*tab)->by_name[name];
+		(*tab)->by_name[name] = new_entry;
 	}
 
-	new_entry->next = curr_entry;
-	prev_entry->next = new_entry;
-}
-
-void free_table(table tab) {
-	table prev_entry, curr_entry = tab;
-	while (curr_entry != NULL) {
-		prev_entry = curr_entry;
-		curr_entry = curr_entry->next;
-		free(prev_entry->key); /* Didn't forget you!ssss */
-		free(prev_entry);
-	}
+	/* Append to the insertion order list */
+	if ((*tab)->tail == NULL) (*tab)->head = new_entry;
+	else (*tab)->tail->next = new_entry;
+	(*tab)->tail = new_entry;
 }
 
 void add_value_to_type(table tab, long to_add, symbol_type type) {
-	table curr_entry;
+	table_entry *curr_entry;
 	/* for each entry, add value to_add if same type */
-	for (curr_entry = tab; curr_entry != NULL; curr_entry = curr_entry->next) {
+	for (curr_entry = tab->head; curr_entry != NULL; curr_entry = curr_entry->next) {
 		if (curr_entry->type == type) {
 			curr_entry->value += to_add;
 		}
 	}
 }
 
-table filter_table_by_type(table tab, symbol_type type) {
-	table new_table = NULL;
-	/* For each entry, check if has the type. if so, insert to the new table. */
-	do {
-		if (tab->type == type) {
-			add_table_item(&new_table, tab->key, tab->value, tab->type);
-		}
-	} while ((tab = tab->next) != NULL);
-	return new_table; /* It holds a pointer to the first entry, dynamically-allocated, so it's fine (not in stack) */
+/**
+ * Sorts the array of entries by value, keeping the original order of equal values (merge sort)
+ * @param entries The entries to sort
+ * @param temp A buffer of the same size, for merging
+ * @param count The count of the entries
+ */
+static void sort_entries_by_value(table_entry **entries, table_entry **temp, long count) {
+	long i, j, k, middle = count / 2;
+	if (count < 2) return;
+	sort_entries_by_value(entries, temp, middle);
+	sort_entries_by_value(entries + middle, temp, count - middle);
+	/* Already in order, nothing to merge */
+	if (entries[middle - 1]->value <= entries[middle]->value) return;
+	memcpy(temp, entries, count * sizeof(table_entry *));
+	for (i = 0, j = middle, k = 0; i < middle && j < count; k++) {
+		entries[k] = temp[j]->value < temp[i]->value ? temp[j++] : temp[i++];
+	}
+	while (i < middle) entries[k++] = temp[i++];
+	while (j < count) entries[k++] = temp[j++];
 }
 
-table_entry *find_by_types(table tab, char *key, int symbol_count, ...) {
-	int i;
-	symbol_type *valid_symbol_types = calloc_with_check((symbol_count) * sizeof(int));
-	/* Build a list of the valid types */
-	va_list arglist;
-	va_start(arglist, symbol_count);
-	for (i = 0; i < symbol_count; i++) {
-		valid_symbol_types[i] = va_arg(arglist, symbol_type);
+table_entry **filter_table_by_type(table tab, symbol_type type) {
+	long count = 0;
+	table_entry *curr_entry, **result, **temp;
+	/* Count the matching entries first, so the result is allocated once */
+	for (curr_entry = tab->head; curr_entry != NULL; curr_entry = curr_entry->next) {
+		if (curr_entry->type == type) count++;
 	}
-	va_end(arglist);
-	/* table null => nothing to dos */
-	if (tab == NULL) {
-		free(valid_symbol_types);
-		return NULL;
+	result = arena_alloc(tab->mem, (count + 1) * sizeof(table_entry *));
+	if (count == 0) return result;
+	/* For each entry, check if has the type. if so, put it in the result. */
+	count = 0;
+	for (curr_entry = tab->head; curr_entry != NULL; curr_entry = curr_entry->next) {
+		if (curr_entry->type == type) result[count++] = curr_entry;
 	}
-	/* iterate over table and then over array of valid. if type is valid and same key, return the entry. */
-	do {
-		for (i = 0; i < symbol_count; i++) {
-			if (valid_symbol_types[i] == tab->type && strcmp(key, tab->key) == 0) {
-				free(valid_symbol_types);
-				return tab;
-			}
+	temp = arena_alloc(tab->mem, count * sizeof(table_entry *));
+	sort_entries_by_value(result, temp, count);
+	return result; /* NULL-terminated - the arena zeroed the last cell */
+}
+
+table_entry *find_by_types(table tab, long name, unsigned int types) {
+	table_entry *curr_entry, *found = NULL;
+	tab->lookups++;
+	/* No entries of the name yet */
+	if (name == NONE_NAME || name >= tab->by_name_count) return NULL;
+	/* iterate over the name's entries only - all of the same name, so just the type is compared */
+	for (curr_entry = tab->by_name[name]; curr_entry != NULL; curr_entry = curr_entry->name_next) {
+		tab->probes++;
+		if (types & SYMBOL_MASK(curr_entry->type)) {
+			/* The lists are newest-first, so keep looking for the earliest inserted match */
+			found = curr_entry;
 		}
-	} while ((tab = tab->next) != NULL);
-	/* not found, return NULL */
-	free(valid_symbol_types);
-	return NULL;
-}
\ No newline at end of file
+	}
+	/* not found => NULL */
+	return found;
+}
@@ -1,6 +1,8 @@
-/* Implements a dynamically-allocated symbol table */
+/* Implements a dynamically-allocated symbol table, keyed by the ids of the symbol names */
 #ifndef _TABLE_H
 #define _TABLE_H
+#include "arena.h"
+#include "names.h"
 
 /** A symbol type */
 typedef enum symbol_type {
@@ -12,35 +14,58 @@ typedef enum symbol_type {
 	ENTRY_SYMBOL
 } symbol_type;
 
-/** pointer to table entry is just a table. */
-typedef struct entry* table;
+/** Builds a type mask for find_by_types from a single symbol type */
+#define SYMBOL_MASK(type) (1u << (type))
 
 /** A single table entry */
 typedef struct entry {
-	/** Next entry in table */
-	table next;
+	/** Next entry in table, by insertion order */
+	struct entry *next;
+	/** Next (older) entry of the same name */
+	struct entry *name_next;
+	/** Id of the symbol name, in the table's names - the key */
+	long name;
 	/** Address of the symbol */
-	short value;
-	/** Key (symbol name) is a string (aka char*) */
+	long value;
+	/** The symbol name itself, as stored once in the names table */
 	char *key;
 	/** Symbol type */
 	symbol_type type;
 } table_entry;
 
+/** The table itself - entries by insertion order, indexed by their name ids */
+typedef struct symbol_table {
+	/** First and last entries, by insertion order */
+	table_entry *head;
+	table_entry *tail;
+	/** The newest entry of each name id, each is a list of the entries of that name (NULL if none) */
+	table_entry **by_name;
+	/** Count of cells of by_name - ids from it on have no entries yet */
+	long by_name_count;
+	/** The names table which the keys are ids in */
+	name_table *names;
+	/** The arena which the table and it's entries are allocated from */
+	arena *mem;
+	/** Count of lookups (find_by_types), and of the entries they went over - for --stats */
+	long lookups;
+	long probes;
+} *table;
+
 /**
- * Adds an item to the table, keeping it sorted.
- * @param tab A pointer to the table
- * @param key The key of the entry to insert
- * @param value The value of the entry to insert
- * @param type The type of the entry to insert
+ * Creates a new, empty table. It's released with the arena of the names table.
+ * @param names The names table of the keys. The table and it's entries are allocated from it's arena
+ * @return The new table
  */
-void add_table_item(table *tab, char *key, long value, symbol_type type);
+table create_table(name_table *names);
 
 /**
- * Deallocates all the memory required by the table.
- * @param tab The table to deallocate
+ * Adds an item to the table.
+ * @param tab A pointer to the table
+ * @param name The key of the entry to insert - the id of the symbol name
+ * @param value The value of the entry to insert
+ * @param type The type of the entry to insert
  */
-void free_table(table tab);
+void add_table_item(table *tab, long name, long value, symbol_type type);
 
 /**
  * Adds the value to add into the value of each entry
@@ -51,20 +76,20 @@ void free_table(table tab);
 void add_value_to_type(table tab, long to_add, symbol_type type);
 
 /**
- * Returns all the entries by their type in a new table
+ * Returns all the entries by their type, sorted by value (ascending)
  * @param tab The table
  * @param type The type to look for
- * @return A new table, which contains the entries
+ * @return A new NULL-terminated array of the entries, allocated from the table's arena
  */
-table filter_table_by_type(table tab, symbol_type type);
+table_entry **filter_table_by_type(table tab, symbol_type type);
 
 /**
  * Find entry from the only specified types
  * @param tab The table
- * @param symbol_count The count of given types
- * @param ... The types to filter
+ * @param name The key to look for - the id of the symbol name (NONE_NAME is never found)
+ * @param types The types to filter, as a mask of SYMBOL_MASK(type) values
  * @return The entry if found, NULL if not found
  */
-table_entry *find_by_types(table tab,char *key, int symbol_count, ...);
+table_entry *find_by_types(table tab, long name, unsigned int types);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,11 @@
+; Prints the digits from FIRST down to 1, a line each, by SHOW of link_show.as
+.extern SHOW
+.entry NEWLINE
+MAIN: mov FIRST, r1
+LOOP: jsr SHOW
+      dec r1
+      cmp #48, r1
+      bne %LOOP
+      stop
+FIRST: .data 53
+NEWLINE: .data 10
@@ -0,0 +1,6 @@
+; Prints the digit in r1, and a line break
+.entry SHOW
+.extern NEWLINE
+SHOW: prn r1
+      prn NEWLINE
+      rts
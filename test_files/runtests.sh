@@ -0,0 +1,50 @@
+#!/usr/bin/env bash
+
+# Assembles the sample programs, links and runs them, and compares every output to the expected one:
+# $prefix.expected.{ob,ext,ent} (by cmpfiles.sh), and $prefix.expected.out for what the simulator printed.
+# Run by "make test", from the project's directory (the tools are in the parent of this one)
+
+cd "$(dirname "$0")" || exit 1
+tools=..
+failed=0
+
+# Fails the tests with a message, if the output of the comparison isn't empty
+expect_same() {
+  if [ -n "$2" ]; then
+    echo "FAILED: $1"
+    echo "$2"
+    failed=1
+  fi
+}
+
+# Valid programs - with relative addressing (%label), externals and entries
+"$tools/assembler" allvalid_relative link_main link_show > /dev/null 2>&1
+for prefix in allvalid_relative link_main link_show
+do
+  expect_same "$prefix" "$(bash cmpfiles.sh $prefix 2>&1)"
+done
+
+# Two modules linked into a single image, which the simulator runs
+"$tools/linker" -o link link_main link_show.ob > /dev/null 2>&1
+expect_same "link" "$(bash cmpfiles.sh link 2>&1)"
+"$tools/simulator" link.ob > link.out 2>&1
+expect_same "simulator" "$(diff link.out link.expected.out 2>&1)"
+
+# The cache - a miss assembles the source, and a hit restores the same outputs without assembling it (no words)
+cache_dir=$(mktemp -d)
+"$tools/assembler" --cache "$cache_dir" --stats miss.json allvalid_relative > /dev/null 2>&1
+rm -f allvalid_relative.ob allvalid_relative.ext allvalid_relative.ent
+"$tools/assembler" --cache "$cache_dir" --stats hit.json allvalid_relative > /dev/null 2>&1
+expect_same "cache hit" "$(bash cmpfiles.sh allvalid_relative 2>&1)"
+grep -q '"words": 0' miss.json && expect_same "cache miss" "the source wasn't assembled"
+grep -q '"words": 0' hit.json || expect_same "cache hit" "the source was assembled again"
+rm -rf "$cache_dir" miss.json hit.json
+
+# Leave just the sources and the expected outputs
+for prefix in allvalid_relative link_main link_show link
+do
+  rm -f $prefix.ob $prefix.ext $prefix.ent $prefix.out
+done
+
+if [ $failed -eq 0 ]; then echo "All tests passed."; fi
+exit $failed
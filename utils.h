@@ -3,12 +3,28 @@
 #define _UTILS_H
 
 #include "globals.h"
+#include "arena.h"
 
+/** Maximum length of a formatted error message - the messages hold a slice of a line at most */
+#define MAX_ERROR_LENGTH (MAX_LINE_LENGTH * 4)
+
+/** A single collected error */
+typedef struct diagnostic_record {
+	/** The line of the error, or 0 if it's about the whole source */
+	long line_number;
+	char *message;
+	struct diagnostic_record *next;
+} diagnostic_record;
+
+/** Collects the errors of a source as records, allocated from an arena - rather than printing them */
+typedef struct diagnostic_sink {
+	arena *mem;
+	/** The records, by the order they were reported */
+	diagnostic_record *first;
+	diagnostic_record *last;
+	long count;
+} diagnostic_sink;
 
-/** moves the index to the next place in string where the char isn't white */
-#define MOVE_TO_NOT_WHITE(string, index) \
-        for (;string[(index)] && (string[(index)] == '\t' || string[(index)] == ' '); (++(index)))\
-        ;
 
 /**
  * Concatenates both string to a new allocated memory
@@ -19,27 +35,19 @@
 char *strallocat(char *s0, char* s1);
 
 /**
- * Finds the defined label in the code if exists, and saves it into the buffer.
- * Returns whether syntax error found.
- * @param line The source line to find in
- * @param symbol_dest The buffer for copying the found label in
- * @return Whether syntax error found
- */
-bool find_label(line_info line, char *symbol_dest);
-
-/**
- * Returns the instruction enum by the instruction's name, without the opening '.'
- * @param name The instruction name, without the '.'
- * @return The instruction enum if found, NONE_INST if not found.
+ * Copies a file name without it's extension - from it's first dot, leading dots aside
+ * @param filename The file name
+ * @return A pointer to the new, allocated copy
  */
-instruction find_instruction_by_name(char *name);
+char *strip_extension(char *filename);
 
 /**
  * Returns whether the string is a valid 21-bit integer
  * @param string The number string
+ * @param length The length of the number string
  * @return Whether a valid 21-bit signed integer.
  */
-bool is_int(char* string);
+bool is_int(char* string, int length);
 
 /**
  * Allocates memory in the required size. Exits the program if failed.
@@ -51,23 +59,34 @@ void *calloc_with_check(long size);
 /**
  * Returns whether a label can be defined with the specified name.
  * @param name The label name
+ * @param length The length of the label name
  * @return Whether the specified name is valid,
  */
-bool is_valid_label_name(char* name);
+bool is_valid_label_name(char* name, int length);
 
 /**
  * Returns whether a string is alphanumeric.
  * @param string The string
+ * @param length The length of the string
  * @return Whether it's alphanumeric
  */
-bool is_alphanumeric_str(char *string);
+bool is_alphanumeric_str(char *string, int length);
 
-/*Returns TRUE if name is saved word*/
-bool is_reserved_word(char *name);
+/*Returns TRUE if name (of length chars) is saved word*/
+bool is_reserved_word(char *name, int length);
+
+/**
+ * Appends an error to a sink
+ * @param sink The sink
+ * @param line_number The line of the error, or 0 if it's about the whole source
+ * @param message The message, which is copied
+ */
+void add_diagnostic(diagnostic_sink *sink, long line_number, char *message);
 
 /**
  * Prints a detailed error message, including file name and line number by the specified message,
  * formatted as specified in App. B of "The C Programming language" for printf.
+ * If the line has a diagnostic sink, the error is appended to it instead.
  * @param message The error message
  * @param ... The arguments to format into the message
  * @return printf result of the message
@@ -75,10 +94,10 @@ bool is_reserved_word(char *name);
 int printf_line_error(line_info line, char *message, ...);
 
 /**
- * Frees all the dynamically-allocated memory for the code image.
- * @param code_image A pointer to the code images buffer
- * @param fic The final instruction counter value
+ * Returns the hash of a string (FNV-1a)
+ * @param string The string
+ * @return The hash value
  */
-void free_code_image(machine_word **code_image, long fic);
+unsigned long hash_string(char *string);
 
 #endif
\ No newline at end of file
@@ -1,104 +1,343 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include "writefiles.h"
 #include "utils.h"
 #include "table.h"
+#include "source.h"
+
+char *output_extensions[OUTPUT_COUNT(TRUE)] = {".ob", ".ext", ".ent", ".obj"};
+
+/** Minimum count of digits of an address (like "%.4ld") */
+#define ADDRESS_DIGITS 4
+
+/** The decimal digits of 00-99, in pairs - for converting two digits at a time */
+static const char decimal_pairs[] =
+		"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+		"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899";
+
+/** The hexadecimal digits, by value */
+static const char hex_digits[] = "0123456789ABCDEF";
+
+/**
+ * Returns the count of decimal digits of a number (like "%.<min_digits>ld" prints), including the sign
+ * @param value The number
+ * @param min_digits The minimum count of digits, zero-padded
+ * @return The count of chars
+ */
+static int decimal_length(long value, int min_digits);
+
+/**
+ * Puts a number in decimal into a buffer, like "%.<min_digits>ld" (no terminator)
+ * @param dest Where to put the number
+ * @param value The number
+ * @param min_digits The minimum count of digits, zero-padded
+ * @return A pointer right after the number
+ */
+static char *put_decimal(char *dest, long value, int min_digits);
 
 /**
- * Writes the code and data image into an .ob file, with lengths on top
- * @param memory_img The code image
- * @param data_img The data image
- * @param icf The final instruction counter
- * @param dcf The final data counter
+ * Checks whether a file already has exactly the given content
+ * @param full_filename The file name
+ * @param text The content
+ * @param length The length of the content
+ * @return Whether the file exists with the same content
+ */
+static bool has_same_content(char *full_filename, char *text, long length);
+
+/**
+ * Writes the words of a module into an .ob file, with lengths on top
+ * @param module The module
  * @param filename The filename, without the extension
+ * @param output The stream to print the errors to
+ * @return Whether succeeded
+ */
+static bool write_ob(object_module *module, char *filename, FILE *output);
+
+/**
+ * Returns the text of the .ob file of a module
+ * @param module The module
+ * @param length Where to return the length of the text
+ * @return The new text
+ */
+static char *ob_text(object_module *module, long *length);
+
+/**
+ * Returns the text of symbols, as in the .ent & .ext files
+ * @param symbols The symbols
+ * @param count The count of symbols
+ * @param length Where to return the length of the text
+ * @return The new text
+ */
+static char *symbols_text(object_symbol *symbols, long count, long *length);
+
+/**
+ * Writes a buffer into a stream, at once
+ * @param text The content to write
+ * @param length The length of the content
+ * @param stream The stream
+ * @param file_extension The extension of the content's file, for the errors
+ * @param output The stream to print the errors to
  * @return Whether succeeded
  */
-static bool write_ob(machine_word **memory_img, long *data_img, long icf, long dcf, char *filename);
+static bool write_buffer_to_stream(char *text, long length, FILE *stream, char *file_extension, FILE *output);
 
 /**
- * Writes a symbol table to a file. Each symbol and it's address in line, separated by a single space.
- * @param tab The symbol table to write
+ * Writes symbols to a file. Each symbol and it's address in line, separated by a single space.
+ * @param symbols The symbols to write
+ * @param count The count of symbols
  * @param filename The filename without the extension
  * @param file_extension The extension of the file, including dot before
+ * @param output The stream to print the errors to
  * @return Whether succeeded
  */
-static bool write_table_to_file(table tab, char *filename, char *file_extension);
+static bool write_symbols_to_file(object_symbol *symbols, long count, char *filename, char *file_extension,
+                                  FILE *output);
+
+/**
+ * Puts the entries of the table into symbols
+ * @param entries The NULL-terminated entries array
+ * @param count Where to return the count of symbols
+ * @param mem The arena to allocate the symbols from
+ * @return The symbols
+ */
+static object_symbol *entries_to_symbols(table_entry **entries, long *count, arena *mem) {
+	long i;
+	object_symbol *symbols;
+	for (*count = 0; entries[*count] != NULL; (*count)++);
+	symbols = arena_alloc(mem, (*count + 1) * sizeof(object_symbol));
+	for (i = 0; i < *count; i++) {
+		symbols[i].name = entries[i]->key;
+		symbols[i].address = entries[i]->value;
+	}
+	return symbols;
+}
+
+void get_object_module(machine_word **memory_img, long icf, long dcf, table symbol_table, object_module *module) {
+	long i;
+	/* Both are ordered by address here, once, for the output (and released with the table's arena) */
+	table_entry **externals = filter_table_by_type(symbol_table, EXTERNAL_REFERENCE);
+	table_entry **entries = filter_table_by_type(symbol_table, ENTRY_SYMBOL);
+
+	module->code_length = icf - IC_INIT_VALUE;
+	module->data_length = dcf;
+	module->words = arena_alloc(symbol_table->mem, (module->code_length + dcf + 1) * sizeof(unsigned int));
+	module->are = arena_alloc(symbol_table->mem, module->code_length + dcf + 1);
+	for (i = 0; i < module->code_length + dcf; i++) {
+		if (memory_img[i]->length > 0) {
+			module->words[i] = (memory_img[i]->word.code->opcode << 8) |
+			                   (memory_img[i]->word.code->funct) << 4 |
+			                   (memory_img[i]->word.code->src_addressing << 2) |
+			                   (memory_img[i]->word.code->dest_addressing);
+		} else {
+			/* Only the lowest 12 bits of the data are kept */
+			module->words[i] = (unsigned int) (memory_img[i]->word.data->data & 0xFFF);
+		}
+		module->are[i] = (char) memory_img[i]->word.code->ARE;
+	}
+	module->entries = entries_to_symbols(entries, &module->entry_count, symbol_table->mem);
+	module->externals = entries_to_symbols(externals, &module->external_count, symbol_table->mem);
+}
 
 int write_output_files(machine_word **memory_img, long *data_img, long icf, long dcf, char *filename,
-                       table symbol_table) {
+                       table symbol_table, bool binary, output_streams *streams, FILE *output) {
+	object_module module;
+	get_object_module(memory_img, icf, dcf, symbol_table, &module);
+	if (streams != NULL) return write_object_streams(&module, binary, streams, output);
+	return write_text_object(&module, filename, output) && (!binary || write_binary_object(&module, filename, output));
+}
+
+bool write_text_object(object_module *module, char *filename, FILE *output) {
+	/* Write .ob file, then *.ext and *.ent files */
+	return write_ob(module, filename, output) &&
+	       write_symbols_to_file(module->externals, module->external_count, filename, ".ext", output) &&
+	       write_symbols_to_file(module->entries, module->entry_count, filename, ".ent", output);
+}
+
+bool write_binary_object(object_module *module, char *filename, FILE *output) {
 	bool result;
-	table externals = filter_table_by_type(symbol_table, EXTERNAL_REFERENCE);
-	table entries = filter_table_by_type(symbol_table, ENTRY_SYMBOL);
-	/* Write .ob file */
-	result = write_ob(memory_img, data_img, icf, dcf, filename) &&
-	         /* Write *.ent and *.ext files: call with symbols from external references type or entry type only */
-	         write_table_to_file(externals, filename, ".ext") &&
-	         write_table_to_file(entries, filename, ".ent");
-	/* Release filtered tables */
-	free_table(externals);
-	free_table(entries);
+	long size = binary_object_size(module);
+	unsigned char *data = calloc_with_check(size + 1);
+	put_binary_object(data, module);
+	result = write_buffer_to_file((char *) data, size, filename, ".obj", output);
+	free(data);
 	return result;
 }
 
-static bool write_ob(machine_word **memory_img, long *data_img, long icf, long dcf, char *filename) {
-	int i;
-	int val;
-	char _ARE;
-	FILE *file_desc;
-	/* add extension of file to open */
-	char *output_filename = strallocat(filename, ".ob");
-	/* Try to open the file for writing */
-	file_desc = fopen(output_filename, "w");
-	free(output_filename);
-	if (file_desc == NULL) {
-		printf("Can't create or rewrite to file %s.", output_filename);
-		return FALSE;
+bool write_object_streams(object_module *module, bool binary, output_streams *streams, FILE *output) {
+	long length;
+	char *text;
+	bool result;
+	if (binary) {
+		length = binary_object_size(module);
+		text = calloc_with_check(length + 1);
+		put_binary_object((unsigned char *) text, module);
+	} else {
+		text = ob_text(module, &length);
+	}
+	result = write_buffer_to_stream(text, length, streams->object, binary ? ".obj" : ".ob", output);
+	free(text);
+	/* Then the externals & the entries, by the files order */
+	if (result && streams->externals != NULL) {
+		text = symbols_text(module->externals, module->external_count, &length);
+		result = write_buffer_to_stream(text, length, streams->externals, ".ext", output);
+		free(text);
+	}
+	if (result && streams->entries != NULL) {
+		text = symbols_text(module->entries, module->entry_count, &length);
+		result = write_buffer_to_stream(text, length, streams->entries, ".ent", output);
+		free(text);
 	}
+	return result;
+}
+
+static bool write_ob(object_module *module, char *filename, FILE *output) {
+	long length;
+	bool result;
+	char *text = ob_text(module, &length);
+	result = write_buffer_to_file(text, length, filename, ".ob", output);
+	free(text);
+	return result;
+}
+
+static char *ob_text(object_module *module, long *length) {
+	long i, word_count = module->code_length + module->data_length;
+	int address_length;
+	unsigned int val;
+	char *text, *curr;
+	/* Each word is "\n<address> <3 hex digits> <ARE>", and the addresses are at most as long as the last one */
+	address_length = decimal_length(IC_INIT_VALUE + word_count - 1, ADDRESS_DIGITS);
+	text = calloc_with_check(decimal_length(module->code_length, 1) + 1 + decimal_length(module->data_length, 1) +
+	                         word_count * (address_length + 7) + 1);
 
 	/* print data/code word count on top */
-	fprintf(file_desc, "%ld %ld", icf - IC_INIT_VALUE, dcf);
+	curr = put_decimal(text, module->code_length, 1);
+	*curr++ = ' ';
+	curr = put_decimal(curr, module->data_length, 1);
 
-	/* starting from index 0, not IC_INIT_VALUE as icf, so we have to subtract it. */
-	for (i = 0; i < icf - IC_INIT_VALUE+dcf; i++) {
-		if (memory_img[i]->length > 0) {
-			val = (memory_img[i]->word.code->opcode << 8) |
-				  (memory_img[i]->word.code->funct) << 4 |
-				  (memory_img[i]->word.code->src_addressing << 2) |
-				  (memory_img[i]->word.code->dest_addressing);
-		} else {
-			/* We need to cut the value, keeping only it's 21 lsb, and include the ARE in the whole party as well: */
-			val = (memory_img[i]->word.data->data);
-		}
-		_ARE = memory_img[i]->word.code->ARE;
+	for (i = 0; i < word_count; i++) {
+		/* Write the value - it's lowest 12 bits, as 3 hex digits */
+		val = module->words[i];
+		*curr++ = '\n';
+		curr = put_decimal(curr, i + IC_INIT_VALUE, ADDRESS_DIGITS);
+		*curr++ = ' ';
+		*curr++ = hex_digits[(val >> 8) & 0xF];
+		*curr++ = hex_digits[(val >> 4) & 0xF];
+		*curr++ = hex_digits[val & 0xF];
+		*curr++ = ' ';
+		*curr++ = module->are[i];
+	}
+	*length = curr - text;
+	return text;
+}
+
+static bool write_symbols_to_file(object_symbol *symbols, long count, char *filename, char *file_extension,
+                                  FILE *output) {
+	long length;
+	bool result;
+	char *text = symbols_text(symbols, count, &length);
+	/* if no symbols, the file is just empty */
+	result = write_buffer_to_file(text, length, filename, file_extension, output);
+	free(text);
+	return result;
+}
+
+static char *symbols_text(object_symbol *symbols, long count, long *length) {
+	long i, symbol_length;
+	char *text, *curr;
+	/* Each symbol is "<symbol> <address>", separated by line breaks */
+	for (*length = 0, i = 0; i < count; i++) {
+		*length += strlen(symbols[i].name) + 1 + decimal_length(symbols[i].address, ADDRESS_DIGITS) + 1;
+	}
+	curr = text = calloc_with_check(*length + 1);
+	for (i = 0; i < count; i++) {
+		/* No line break before the first line, to avoid extraneous line breaks */
+		if (i > 0) *curr++ = '\n';
+		symbol_length = strlen(symbols[i].name);
+		memcpy(curr, symbols[i].name, symbol_length);
+		curr += symbol_length;
+		*curr++ = ' ';
+		curr = put_decimal(curr, symbols[i].address, ADDRESS_DIGITS);
+	}
+	*length = curr - text;
+	return text;
+}
+
+static int decimal_length(long value, int min_digits) {
+	int length = 1;
+	unsigned long magnitude = value < 0 ? -(unsigned long) value : (unsigned long) value;
+	for (; magnitude >= 10; magnitude /= 10) length++;
+	return (length < min_digits ? min_digits : length) + (value < 0);
+}
 
-		/* Write the value to the file - first */
-		fprintf(file_desc, "\n%.4d %.3X %c", i + 100, val & 0xFFF, _ARE); /* "val & 0xFFF" "Cuts" the msb of the value, keeping only it's lowest 12 bits */
+static char *put_decimal(char *dest, long value, int min_digits) {
+	char digits[24]; /* Enough for any long, backwards */
+	char *curr = digits + sizeof(digits);
+	unsigned long magnitude = value < 0 ? -(unsigned long) value : (unsigned long) value;
+	/* Two digits at a time, from the lowest ones */
+	while (magnitude >= 100) {
+		int pair = (int) (magnitude % 100) * 2;
+		magnitude /= 100;
+		*--curr = decimal_pairs[pair + 1];
+		*--curr = decimal_pairs[pair];
 	}
+	if (magnitude >= 10) {
+		*--curr = decimal_pairs[magnitude * 2 + 1];
+		*--curr = decimal_pairs[magnitude * 2];
+	} else {
+		*--curr = (char) ('0' + magnitude);
+	}
+	while (digits + sizeof(digits) - curr < min_digits) *--curr = '0';
+	if (value < 0) *dest++ = '-';
+	memcpy(dest, curr, digits + sizeof(digits) - curr);
+	return dest + (digits + sizeof(digits) - curr);
+}
 
-	/* Close the file */
+static bool has_same_content(char *full_filename, char *text, long length) {
+	char *data = NULL;
+	long size;
+	bool result;
+	FILE *file_desc = fopen(full_filename, "rb");
+	if (file_desc == NULL) return FALSE;
+	result = read_whole_file(file_desc, &data, &size) && size == length && memcmp(data, text, length) == 0;
 	fclose(file_desc);
-	return TRUE;
+	free(data);
+	return result;
 }
 
-static bool write_table_to_file(table tab, char *filename, char *file_extension) {
+bool write_buffer_to_file(char *text, long length, char *filename, char *file_extension, FILE *output) {
 	FILE *file_desc;
-	/* concatenate filename & extension, and open the file for writing: */
+	bool is_success;
+	/* concatenate filename & extension, and the temporary file's name: */
 	char *full_filename = strallocat(filename, file_extension);
-	file_desc = fopen(full_filename, "w");
-	free(full_filename);
-	/* if failed, print error and exit */
-	if (file_desc == NULL) {
-		printf("Can't create or rewrite to file %s.", full_filename);
-		return FALSE;
+	char *temp_filename;
+	/* Don't touch a file that wouldn't change, so it's timestamp stays as well */
+	if (has_same_content(full_filename, text, length)) {
+		free(full_filename);
+		return TRUE;
 	}
-	/* if table is null, nothing to write */
-	if (tab == NULL) return TRUE;
-
-	/* Write first line without \n to avoid extraneous line breaks */
-	fprintf(file_desc, "%s %.4d", tab->key, tab->value);
-	while ((tab = tab->next) != NULL) {
-		fprintf(file_desc, "\n%s %.4d", tab->key, tab->value);
+	temp_filename = strallocat(full_filename, ".tmp");
+	/* Unbuffered, so the content is written with a single write */
+	if ((file_desc = fopen(temp_filename, "wb")) != NULL) setvbuf(file_desc, NULL, _IONBF, 0);
+	is_success = file_desc != NULL && fwrite(text, 1, length, file_desc) == (size_t) length;
+	if (file_desc != NULL && fclose(file_desc) != 0) is_success = FALSE;
+	/* Replace the file at once */
+	if (is_success && rename(temp_filename, full_filename) != 0) is_success = FALSE;
+	/* if failed, print error */
+	if (!is_success) {
+		if (file_desc != NULL) remove(temp_filename);
+		fprintf(output, "Can't create or rewrite to file %s.", full_filename);
 	}
-	fclose(file_desc);
-	return TRUE;
-}
\ No newline at end of file
+	free(temp_filename);
+	free(full_filename);
+	return is_success;
+}
+
+static bool write_buffer_to_stream(char *text, long length, FILE *stream, char *file_extension, FILE *output) {
+	bool is_success = fwrite(text, 1, length, stream) == (size_t) length;
+	/* Flushed right away, so whoever reads the stream gets the whole output of the file */
+	if (fflush(stream) != 0) is_success = FALSE;
+	if (!is_success) fprintf(output, "Can't write the %s output to it's stream.", file_extension);
+	return is_success;
+}
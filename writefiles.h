@@ -3,6 +3,22 @@
 #define _WRITEFILES_H
 #include "globals.h"
 #include "table.h"
+#include "object.h"
+
+/** Count of the output files, with and without the binary object */
+#define OUTPUT_COUNT(binary) ((binary) ? 4 : 3)
+
+/** The extensions of the output files of a source, in this order. The binary object is last, and optional */
+extern char *output_extensions[OUTPUT_COUNT(TRUE)];
+
+/** Where the outputs of a file are streamed to, instead of the files next to it */
+typedef struct output_streams {
+	/** The stream of the object - it's text (.ob), or the binary object (.obj) if binary */
+	FILE *object;
+	/** The streams of the externals (.ext) and the entries (.ent), or NULL if they're dropped */
+	FILE *externals;
+	FILE *entries;
+} output_streams;
 
 /**
  * Writes the output files of a single assembled file
@@ -11,11 +27,63 @@
  * @param icf The final instruction counter
  * @param dcf The final data counter
  * @param filename The filename (without the extension)
- * @param ent_table The entries table
- * @param ext_table The external references table
+ * @param symbol_table The symbol table, with the entries and the external references
+ * @param binary Whether to write the binary object (.obj) as well
+ * @param streams The streams to write the outputs to, or NULL to write the files
+ * @param output The stream to print the errors to
  * @return Whether succeeded
  */
 int write_output_files(machine_word **memory_img, long *data_img, long icf, long dcf, char *filename,
-                       table symbol_table);
+                       table symbol_table, bool binary, output_streams *streams, FILE *output);
+
+/**
+ * Builds the module of a single assembled file - each word's value and ARE, and the entries & externals by address
+ * @param memory_img The memory image - the code, then the data
+ * @param icf The final instruction counter
+ * @param dcf The final data counter
+ * @param symbol_table The symbol table, with the entries and the external references
+ * @param module The module to build. It's allocated from the table's arena
+ */
+void get_object_module(machine_word **memory_img, long icf, long dcf, table symbol_table, object_module *module);
+
+/**
+ * Writes a buffer into a file, at once - into a temporary file first, which then replaces the file.
+ * So the file has either all of it's new content, or it's old one. A file with the same content isn't rewritten.
+ * @param text The content to write
+ * @param length The length of the content
+ * @param filename The filename without the extension
+ * @param file_extension The extension of the file, including dot before
+ * @param output The stream to print the errors to
+ * @return Whether succeeded
+ */
+bool write_buffer_to_file(char *text, long length, char *filename, char *file_extension, FILE *output);
+
+/**
+ * Writes the text files of a module - .ob, .ext and .ent
+ * @param module The module
+ * @param filename The filename (without the extension)
+ * @param output The stream to print the errors to
+ * @return Whether succeeded
+ */
+bool write_text_object(object_module *module, char *filename, FILE *output);
+
+/**
+ * Writes the binary object file of a module (.obj)
+ * @param module The module
+ * @param filename The filename (without the extension)
+ * @param output The stream to print the errors to
+ * @return Whether succeeded
+ */
+bool write_binary_object(object_module *module, char *filename, FILE *output);
+
+/**
+ * Writes the outputs of a module to streams, each with the same content as it's file
+ * @param module The module
+ * @param binary Whether the object is the binary object (.obj), rather than the text one (.ob)
+ * @param streams The streams
+ * @param output The stream to print the errors to
+ * @return Whether succeeded
+ */
+bool write_object_streams(object_module *module, bool binary, output_streams *streams, FILE *output);
 
 #endif
\ No newline at end of file